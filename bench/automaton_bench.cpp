@@ -0,0 +1,252 @@
+// Throughput benchmark for AutomatonGrid::evolve().
+//
+//   automaton_bench [--rules life,cyclic,majority,xor] [--sizes 64,256,1024,4096]
+//                   [--storage word32|nibble|bit] [--threads N] [--warmup N]
+//                   [--trials N] [--min-time SECONDS] [--seed N]
+//                   [--format csv|json] [--output FILE]
+//                   [--baseline FILE.csv] [--threshold FRACTION]
+//
+// Every grid is seeded from --seed, so runs are reproducible. Each trial
+// evolves enough generations to last about --min-time seconds; the median
+// trial is reported. With --baseline, results are compared to an earlier CSV
+// run and the exit code is 1 if any case slowed down by more than --threshold.
+
+#include "automation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Options {
+        std::vector<std::string> rules{"life", "cyclic", "majority", "xor"};
+        std::vector<size_t> sizes{64, 256, 1024, 4096};
+        std::string storage = "word32";
+        size_t threads = 1;
+        size_t warmup = 3;
+        size_t trials = 5;
+        double min_time = 0.2;
+        uint64_t seed = 1;
+        std::string format = "csv";
+        std::string output;
+        std::string baseline;
+        double threshold = 0.10;
+    };
+
+    struct Result {
+        std::string rule;
+        size_t size;
+        std::string storage;
+        size_t threads;
+        size_t generations;      // per trial
+        double ns_per_generation;
+        double cells_per_second;
+    };
+
+    std::vector<std::string> split(const std::string& text, char separator) {
+        std::vector<std::string> parts;
+        std::stringstream stream(text);
+        std::string part;
+        while (std::getline(stream, part, separator)) {
+            if (!part.empty()) parts.push_back(part);
+        }
+        return parts;
+    }
+
+    Options parse_options(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--rules") options.rules = split(value(), ',');
+            else if (arg == "--sizes") {
+                options.sizes.clear();
+                for (const auto& size : split(value(), ',')) options.sizes.push_back(std::stoull(size));
+            }
+            else if (arg == "--storage") options.storage = value();
+            else if (arg == "--threads") options.threads = std::stoull(value());
+            else if (arg == "--warmup") options.warmup = std::stoull(value());
+            else if (arg == "--trials") options.trials = std::max<size_t>(1, std::stoull(value()));
+            else if (arg == "--min-time") options.min_time = std::stod(value());
+            else if (arg == "--seed") options.seed = std::stoull(value());
+            else if (arg == "--format") options.format = value();
+            else if (arg == "--output") options.output = value();
+            else if (arg == "--baseline") options.baseline = value();
+            else if (arg == "--threshold") options.threshold = std::stod(value());
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (options.format != "csv" && options.format != "json") {
+            throw std::invalid_argument("--format must be csv or json");
+        }
+        return options;
+    }
+
+    AutomatonGrid::RuleFunction rule_by_name(const std::string& name) {
+        if (name == "life") return &rules::game_of_life_rule;
+        if (name == "cyclic") return &rules::cyclic_rule;
+        if (name == "majority") return &rules::majority_rule;
+        if (name == "xor") return &rules::xor_rule;
+        throw std::invalid_argument("unknown rule " + name);
+    }
+
+    CellStorage storage_by_name(const std::string& name) {
+        if (name == "word32") return CellStorage::Word32;
+        if (name == "nibble") return CellStorage::Nibble;
+        if (name == "bit") return CellStorage::Bit;
+        throw std::invalid_argument("unknown storage " + name);
+    }
+
+    AutomatonGrid make_grid(const Options& options, const std::string& rule, size_t size) {
+        AutomatonGrid grid(size, size, rule_by_name(rule), storage_by_name(options.storage));
+        grid.set_threads(options.threads);
+        const unsigned states = rule == "life" ? 2 : 16;
+        grid.randomize(options.seed, 1 - 1.0 / states, states);
+        return grid;
+    }
+
+    double seconds_for(AutomatonGrid& grid, size_t generations) {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < generations; ++i) {
+            grid.evolve();
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    Result run_case(const Options& options, const std::string& rule, size_t size) {
+        AutomatonGrid grid = make_grid(options, rule, size);
+
+        // Warm-up doubles as calibration for the generations per trial
+        size_t generations = 1;
+        double elapsed = seconds_for(grid, std::max<size_t>(options.warmup, 1));
+        const double per_generation = elapsed / static_cast<double>(std::max<size_t>(options.warmup, 1));
+        if (per_generation > 0) {
+            generations = std::max<size_t>(1, static_cast<size_t>(options.min_time / per_generation));
+        }
+
+        std::vector<double> trials;
+        for (size_t trial = 0; trial < options.trials; ++trial) {
+            trials.push_back(seconds_for(grid, generations) / static_cast<double>(generations));
+        }
+        std::sort(trials.begin(), trials.end());
+        const double median = trials[trials.size() / 2];
+
+        return {rule, size, options.storage, grid.threads(), generations,
+                median * 1e9, static_cast<double>(size * size) / median};
+    }
+
+    constexpr const char* csv_header = "rule,size,storage,threads,generations,ns_per_generation,cells_per_second";
+
+    void write_csv(std::ostream& out, const std::vector<Result>& results) {
+        out << csv_header << '\n';
+        out << std::fixed << std::setprecision(1);
+        for (const auto& r : results) {
+            out << r.rule << ',' << r.size << ',' << r.storage << ',' << r.threads << ','
+                << r.generations << ',' << r.ns_per_generation << ',' << r.cells_per_second << '\n';
+        }
+    }
+
+    void write_json(std::ostream& out, const std::vector<Result>& results) {
+        out << "[\n" << std::fixed << std::setprecision(1);
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            out << "  {\"rule\": \"" << r.rule << "\", \"size\": " << r.size
+                << ", \"storage\": \"" << r.storage << "\", \"threads\": " << r.threads
+                << ", \"generations\": " << r.generations
+                << ", \"ns_per_generation\": " << r.ns_per_generation
+                << ", \"cells_per_second\": " << r.cells_per_second << "}"
+                << (i + 1 < results.size() ? "," : "") << '\n';
+        }
+        out << "]\n";
+    }
+
+    std::string key(const std::string& rule, size_t size, const std::string& storage, size_t threads) {
+        return rule + '/' + std::to_string(size) + '/' + storage + '/' + std::to_string(threads);
+    }
+
+    // Returns the number of regressions found against a CSV baseline
+    size_t compare(const std::vector<Result>& results, const std::string& path, double threshold) {
+        std::ifstream in(path);
+        if (!in) {
+            throw std::runtime_error("cannot read baseline " + path);
+        }
+        std::map<std::string, double> baseline;
+        std::string line;
+        // Only CSV baselines are understood; a JSON one would otherwise match nothing
+        if (!std::getline(in, line) || line != csv_header) {
+            throw std::runtime_error("baseline " + path + " is not a CSV written with --format csv");
+        }
+        while (std::getline(in, line)) {
+            const auto fields = split(line, ',');
+            if (fields.size() < 7) continue;
+            baseline[key(fields[0], std::stoull(fields[1]), fields[2], std::stoull(fields[3]))] = std::stod(fields[6]);
+        }
+
+        size_t regressions = 0;
+        for (const auto& r : results) {
+            auto it = baseline.find(key(r.rule, r.size, r.storage, r.threads));
+            if (it == baseline.end()) {
+                std::cerr << "  " << key(r.rule, r.size, r.storage, r.threads) << ": no baseline\n";
+                continue;
+            }
+            const double change = r.cells_per_second / it->second - 1.0;
+            const bool regressed = change < -threshold;
+            regressions += regressed;
+            std::cerr << (regressed ? "REGRESSION " : "  ") << it->first << ": "
+                      << std::showpos << std::fixed << std::setprecision(1) << change * 100.0
+                      << std::noshowpos << "%\n";
+        }
+        return regressions;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        const Options options = parse_options(argc, argv);
+
+        // Opened before any timing so a bad path fails fast
+        std::ofstream file;
+        if (!options.output.empty()) {
+            file.open(options.output);
+            if (!file) {
+                throw std::runtime_error("cannot write output " + options.output);
+            }
+        }
+
+        std::vector<Result> results;
+        for (const auto& rule : options.rules) {
+            for (size_t size : options.sizes) {
+                results.push_back(run_case(options, rule, size));
+                std::cerr << rule << ' ' << size << 'x' << size << ": "
+                          << results.back().cells_per_second / 1e6 << " Mcells/s\n";
+            }
+        }
+
+        std::ostream& out = options.output.empty() ? std::cout : file;
+        if (options.format == "json") {
+            write_json(out, results);
+        } else {
+            write_csv(out, results);
+        }
+        if (!options.output.empty() && !file.flush()) {
+            throw std::runtime_error("failed to write output " + options.output);
+        }
+
+        if (!options.baseline.empty() && compare(results, options.baseline, options.threshold) > 0) {
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "automaton_bench: " << e.what() << std::endl;
+        return 2;
+    }
+    return 0;
+}
@@ -1,5 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #include <span>
 #include <random>
@@ -8,35 +19,479 @@
 class CellState {
     unsigned value_;
 public:
-    explicit CellState(unsigned val = 0);
-    unsigned value() const;
+    explicit CellState(unsigned val = 0) : value_(val % 16) {}
+    unsigned value() const { return value_; }
     void set_value(unsigned val);
-    void randomize();
+    void randomize();   // uniform in [0, 16) from a per-thread generator
 };
 
+namespace detail {
+    // SplitMix64: value `counter` of the stream for `seed`, computed directly
+    // rather than by stepping a generator, so any cell can draw its own number
+    constexpr std::uint64_t counter_random(std::uint64_t seed, std::uint64_t counter) {
+        std::uint64_t z = seed + (counter + 1) * 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // Zobrist-style keys for packed words: a grid's hash is the XOR of the
+    // keys of all its words, so a changed word updates it with two keys. Each
+    // buffer index gets its own seed, so keys at different indices are
+    // unrelated streams rather than shifted copies of one another. Grids that
+    // hash every generation compute the seeds once and keep them.
+    constexpr std::uint64_t zobrist_seed(std::uint64_t index) {
+        return counter_random(0x5a0b7157c0ffee00ull, index);
+    }
+
+    constexpr std::uint64_t zobrist_word(std::uint64_t seed, std::uint64_t value) {
+        return counter_random(seed, value);
+    }
+}
+
+// Anything that maps a 3x3 neighborhood to the next state of its centre cell
+template <typename Rule>
+concept CellRule = std::copy_constructible<Rule> &&
+    requires(const Rule& rule, std::span<const CellState> neighborhood) {
+        { rule(neighborhood) } -> std::convertible_to<CellState>;
+    };
+
 // Now declare `rules` after `CellState`
 namespace rules {
     CellState game_of_life_rule(std::span<const CellState> neighborhood);
     CellState cyclic_rule(std::span<const CellState> neighborhood);
     CellState majority_rule(std::span<const CellState> neighborhood);
     CellState xor_rule(std::span<const CellState> neighborhood);
+
+    // Function objects behind the rules above. Passing one of these (or any
+    // other CellRule) to AutomatonGrid lets the rule inline into the evolve loop.
+    struct GameOfLife {
+        CellState operator()(std::span<const CellState> neighborhood) const {
+            // The total includes the centre cell
+            unsigned live = 0;
+            for (const auto& cell : neighborhood) {
+                live += cell.value() > 0;
+            }
+            bool is_alive = neighborhood[4].value() > 0;
+            return CellState(live == 3 || (is_alive && live == 2) ? 1 : 0);
+        }
+    };
+
+    struct Cyclic {
+        CellState operator()(std::span<const CellState> neighborhood) const {
+            unsigned next_state = (neighborhood[4].value() + 1) % 16;
+            bool should_change = false;
+            for (const auto& cell : neighborhood) {
+                should_change |= cell.value() == next_state;
+            }
+            return CellState(should_change ? next_state : neighborhood[4].value());
+        }
+    };
+
+    struct Majority {
+        CellState operator()(std::span<const CellState> neighborhood) const {
+            std::array<unsigned, 16> count{};
+            for (const auto& cell : neighborhood) {
+                count[cell.value()]++;
+            }
+            // Ties go to the lowest state
+            return CellState(static_cast<unsigned>(std::max_element(count.begin(), count.end()) - count.begin()));
+        }
+    };
+
+    struct Xor {
+        CellState operator()(std::span<const CellState> neighborhood) const {
+            unsigned new_state = 0;
+            for (const auto& cell : neighborhood) {
+                new_state ^= cell.value();
+            }
+            return CellState(new_state);
+        }
+    };
+
+    // Outer-totalistic two-state rule compiled from a rulestring such as
+    // "B3/S23" (or the older "23/3" form) into a table indexed by the 9-bit
+    // alive mask of the neighborhood. Throws std::invalid_argument on bad input.
+    class LifeLike {
+        std::array<std::uint8_t, 512> table_{};
+    public:
+        explicit LifeLike(std::string_view rulestring);
+        CellState operator()(std::span<const CellState> neighborhood) const {
+            unsigned index = 0;
+            for (size_t i = 0; i < 9; ++i) {
+                index |= unsigned{neighborhood[i].value() != 0} << i;
+            }
+            return CellState(table_[index]);
+        }
+    };
 }
 
+// Bits used to store each cell. Nibble holds every CellState value; Bit keeps
+// only alive/dead, so any non-zero value is stored as 1.
+enum class CellStorage : unsigned {
+    Word32 = 32,
+    Nibble = 4,
+    Bit = 1
+};
+
+// Packed cell storage. Every row starts on a fresh 64-bit word, so rows can be
+// written independently and the Bit layout is a plain bitboard per row.
+class CellBuffer {
+    size_t width_ = 0, height_ = 0;
+    unsigned bits_ = 32;
+    size_t stride_ = 0;     // words per row
+    std::vector<std::uint64_t> words_;    // owned storage; empty when wrapping external words
+    std::shared_ptr<void> owner_;         // keeps external words (e.g. a file mapping) alive
+    std::uint64_t* data_ = nullptr;
+
+public:
+    CellBuffer() = default;
+    CellBuffer(size_t w, size_t h, CellStorage storage);
+    // Wrap stride * h words laid out as above without copying them
+    CellBuffer(size_t w, size_t h, CellStorage storage, std::uint64_t* words, std::shared_ptr<void> owner);
+    // Copies always own their words
+    CellBuffer(const CellBuffer& other);
+    CellBuffer& operator=(const CellBuffer& other);
+    CellBuffer(CellBuffer&&) noexcept = default;
+    CellBuffer& operator=(CellBuffer&&) noexcept = default;
+
+    size_t width() const { return width_; }
+    size_t height() const { return height_; }
+    unsigned bits() const { return bits_; }
+    size_t stride() const { return stride_; }
+    size_t size_words() const { return stride_ * height_; }
+    std::uint64_t* data() { return data_; }
+    const std::uint64_t* data() const { return data_; }
+    std::uint64_t* row(size_t y) { return data_ + y * stride_; }
+    const std::uint64_t* row(size_t y) const { return data_ + y * stride_; }
+    unsigned get(size_t x, size_t y) const;
+    void put(size_t x, size_t y, unsigned value);
+    void swap(CellBuffer& other) noexcept;
+
+    template <unsigned Bits>
+    static unsigned load(const std::uint64_t* row, size_t x) {
+        constexpr size_t per_word = 64 / Bits;
+        constexpr std::uint64_t mask = (std::uint64_t{1} << Bits) - 1;
+        return static_cast<unsigned>((row[x / per_word] >> ((x % per_word) * Bits)) & mask);
+    }
+};
+
+// How evolve() computes the next generation. Auto uses the bit-sliced Game of
+// Life engine whenever the grid is eligible for it, and the stencil otherwise.
+enum class EvolveEngine {
+    Auto,
+    Stencil,        // generic 3x3 stencil calling the rule per cell
+    BitSlicedLife   // game_of_life_rule on CellStorage::Bit, 64 cells per word
+};
+
+class ThreadPool;
+
+namespace detail {
+    // Counters gathered inside the evolve pass while metrics or cycle detection
+    // are on, one per band so threads never share a slot. histogram[0] is left
+    // for the caller to derive from the cell count, since it also picks up row
+    // padding.
+    struct alignas(64) CellTally {
+        bool count_cells = true;    // evaluated, changed and histogram
+        const std::uint64_t* zobrist_seeds = nullptr;   // per buffer word; non-null: hash
+        std::uint64_t evaluated = 0;
+        std::uint64_t changed = 0;
+        std::array<std::uint64_t, 16> histogram{};
+        std::uint64_t hash = 0;     // XOR of zobrist_word changes
+
+        // Account for output word `word` (its index in the buffer) replacing `before`
+        template <unsigned Bits>
+        void observe(size_t word, std::uint64_t before, std::uint64_t after) {
+            if (count_cells) {
+                add_word<Bits>(before, after);
+            }
+            if (zobrist_seeds && before != after) {
+                hash ^= zobrist_word(zobrist_seeds[word], before) ^ zobrist_word(zobrist_seeds[word], after);
+            }
+        }
+
+        // Count one stored output word against the word it replaces
+        template <unsigned Bits>
+        void add_word(std::uint64_t before, std::uint64_t after) {
+            const std::uint64_t diff = before ^ after;
+            if constexpr (Bits == 1) {
+                changed += std::popcount(diff);
+                histogram[1] += std::popcount(after);
+            } else if constexpr (Bits == 4) {
+                std::uint64_t any = diff | (diff >> 1);
+                any |= any >> 2;
+                changed += std::popcount(any & 0x1111111111111111ull);
+                for (unsigned shift = 0; shift < 64; shift += 4) {
+                    ++histogram[(after >> shift) & 15];
+                }
+            } else {
+                changed += ((diff & 0xffffffff) != 0) + ((diff >> 32) != 0);
+                ++histogram[after & 15];
+                ++histogram[(after >> 32) & 15];
+            }
+        }
+
+        void merge(const CellTally& other) {
+            hash ^= other.hash;
+            evaluated += other.evaluated;
+            changed += other.changed;
+            for (size_t s = 0; s < histogram.size(); ++s) {
+                histogram[s] += other.histogram[s];
+            }
+        }
+    };
+
+    // One row of the 3x3 stencil over columns [x0, x1). The window slides so
+    // each step loads only the incoming column, and only the first and last
+    // cell of the row wrap. Results are packed into a register and stored a
+    // whole word at a time. Returns true if any cell changed. With `Tally`
+    // each stored word is also passed to `tally`.
+    template <unsigned Bits, bool Tally = false, typename Rule>
+    bool stencil_row(const Rule& rule, const CellBuffer& src, CellBuffer& dst,
+                     size_t width, size_t height, size_t y, size_t x0, size_t x1,
+                     CellTally* tally = nullptr) {
+        constexpr size_t per_word = 64 / Bits;
+        const std::uint64_t* above = src.row(y == 0 ? height - 1 : y - 1);
+        const std::uint64_t* row = src.row(y);
+        const std::uint64_t* below = src.row(y + 1 == height ? 0 : y + 1);
+        std::uint64_t* out = dst.row(y);
+
+        auto load = [](const std::uint64_t* r, size_t x) { return CellState(CellBuffer::load<Bits>(r, x)); };
+
+        const size_t left = x0 == 0 ? width - 1 : x0 - 1;
+        std::array<CellState, 9> window{
+            CellState(), load(above, left), load(above, x0),
+            CellState(), load(row, left),   load(row, x0),
+            CellState(), load(below, left), load(below, x0)
+        };
+
+        std::uint64_t word = 0, changed = 0;
+        auto step = [&](size_t x, size_t right) {
+            window[0] = window[1]; window[1] = window[2]; window[2] = load(above, right);
+            window[3] = window[4]; window[4] = window[5]; window[5] = load(row, right);
+            window[6] = window[7]; window[7] = window[8]; window[8] = load(below, right);
+
+            unsigned value = CellState(rule(std::span<const CellState, 9>(window))).value();
+            if constexpr (Bits == 1) {
+                value = value != 0;
+            }
+            word |= std::uint64_t{value} << ((x % per_word) * Bits);
+            if (x % per_word == per_word - 1) {
+                changed |= word ^ row[x / per_word];
+                if constexpr (Tally) tally->observe<Bits>(y * src.stride() + x / per_word, row[x / per_word], word);
+                out[x / per_word] = word;
+                word = 0;
+            }
+        };
+
+        const size_t interior_end = x1 == width ? x1 - 1 : x1;
+        for (size_t x = x0; x < interior_end; ++x) {
+            step(x, x + 1);
+        }
+        if (x1 == width) {
+            step(width - 1, 0);
+            if (width % per_word != 0) {
+                changed |= word ^ row[width / per_word];
+                if constexpr (Tally) tally->observe<Bits>(y * src.stride() + width / per_word, row[width / per_word], word);
+                out[width / per_word] = word;
+            }
+        }
+        if constexpr (Tally) tally->evaluated += x1 - x0;
+        return changed != 0;
+    }
+
+    // Type-erased stencil specialised for one rule type; the virtual call is
+    // made once per row segment rather than once per cell. A non-null `tally`
+    // selects the counting variant of the stencil.
+    class RuleKernel {
+    public:
+        virtual ~RuleKernel() = default;
+        virtual bool evolve_row(const CellBuffer& src, CellBuffer& dst, size_t width, size_t height,
+                                size_t y, size_t x0, size_t x1, CellTally* tally) const = 0;
+    };
+
+    template <CellRule Rule>
+    class RuleKernelFor final : public RuleKernel {
+        Rule rule_;
+    public:
+        explicit RuleKernelFor(Rule rule) : rule_(std::move(rule)) {}
+        bool evolve_row(const CellBuffer& src, CellBuffer& dst, size_t width, size_t height,
+                        size_t y, size_t x0, size_t x1, CellTally* tally) const override {
+            if (tally) {
+                switch (src.bits()) {
+                    case 1: return stencil_row<1, true>(rule_, src, dst, width, height, y, x0, x1, tally);
+                    case 4: return stencil_row<4, true>(rule_, src, dst, width, height, y, x0, x1, tally);
+                    default: return stencil_row<32, true>(rule_, src, dst, width, height, y, x0, x1, tally);
+                }
+            }
+            switch (src.bits()) {
+                case 1: return stencil_row<1>(rule_, src, dst, width, height, y, x0, x1);
+                case 4: return stencil_row<4>(rule_, src, dst, width, height, y, x0, x1);
+                default: return stencil_row<32>(rule_, src, dst, width, height, y, x0, x1);
+            }
+        }
+    };
+}
+
+// Tile counts for the most recent generation when active-region tracking is on
+struct ActivityStats {
+    size_t tiles = 0;
+    size_t tiles_evaluated = 0;
+    size_t tiles_skipped = 0;
+};
+
+// What one evolve() did, recorded while metrics are enabled
+struct GenerationMetrics {
+    std::uint64_t generation = 0;       // generation produced by this step
+    double seconds = 0;                 // wall time of the evolve() call
+    std::uint64_t cells_evaluated = 0;  // fewer than the grid when tiles are skipped
+    std::uint64_t cells_changed = 0;
+    std::array<std::uint64_t, 16> histogram{};   // cells in each state afterwards
+
+    std::uint64_t population() const;   // non-zero cells
+};
+
+// The cells at generation `start` recur every `period` generations
+struct GridCycle {
+    std::uint64_t start = 0;
+    std::uint64_t period = 0;
+};
+
+// What AutomatonGrid::run() does once a cycle is confirmed
+enum class CycleAction {
+    Stop,   // return at the first generation the cycle was confirmed
+    Skip    // evolve only the remaining generations modulo the period
+};
+
+struct RunResult {
+    std::uint64_t evolved = 0;          // evolve() calls actually made
+    std::optional<GridCycle> cycle;     // set once a cycle was confirmed
+};
+
 // Declare AutomatonGrid class
 class AutomatonGrid {
 public:
     using RuleFunction = CellState (*)(std::span<const CellState>);
+    // 3x3 Moore neighborhood in row-major order, centre cell at index 4
+    using Neighborhood = std::array<CellState, 9>;
+    // evolve() works in square tiles of this many cells; each row of tiles is
+    // one band of parallel work
+    static constexpr size_t tile_size = 64;
 
 private:
-    std::vector<CellState> grid_;
     size_t width_, height_;
-    RuleFunction rule_;
+    std::shared_ptr<const detail::RuleKernel> kernel_;
+    bool life_rule_;    // the rule is rules::game_of_life_rule / rules::GameOfLife
+    CellStorage storage_;
+    EvolveEngine engine_ = EvolveEngine::Auto;
+    CellBuffer grid_;
+    CellBuffer back_;   // next generation is written here, then swapped with grid_
+    std::shared_ptr<ThreadPool> pool_;
+    std::uint64_t generation_ = 0;
+    size_t tiles_x_, tiles_y_;
+    bool track_activity_ = false;
+    std::vector<std::uint8_t> changed_;   // per tile: changed last generation or touched by set()
+    std::vector<std::uint8_t> active_;    // per tile: evaluated this generation
+    ActivityStats activity_;
+    bool metrics_enabled_ = false;
+    std::vector<detail::CellTally> band_tallies_;
+    std::vector<std::array<std::uint64_t, 16>> tile_histograms_;   // reused for skipped tiles
+    std::vector<GenerationMetrics> metrics_history_;   // ring buffer
+    size_t metrics_recorded_ = 0;
+    GenerationMetrics last_metrics_;
+    std::function<void(const GenerationMetrics&)> metrics_sink_;
+    bool hashing_ = false;
+    std::uint64_t hash_ = 0;
+    std::vector<std::uint64_t> zobrist_seeds_;   // zobrist_seed(i) per buffer word while hashing
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> hash_history_;   // (generation, hash) ring
+    size_t hashes_recorded_ = 0;
+    std::optional<GridCycle> cycle_candidate_;
 
 public:
-    AutomatonGrid(size_t w, size_t h, RuleFunction rule);
+    AutomatonGrid(size_t w, size_t h, RuleFunction rule, CellStorage storage = CellStorage::Word32);
+    // Evolve with a rule whose call is compiled into the stencil loop
+    template <CellRule Rule>
+    AutomatonGrid(size_t w, size_t h, Rule rule, CellStorage storage = CellStorage::Word32)
+        : AutomatonGrid(w, h, std::make_shared<const detail::RuleKernelFor<Rule>>(std::move(rule)),
+                        std::is_same_v<Rule, rules::GameOfLife>, storage) {}
     std::pair<size_t, size_t> dimensions() const;
+    CellStorage storage() const;
+    // Throws std::invalid_argument if BitSlicedLife is requested for a grid
+    // that is not game_of_life_rule on CellStorage::Bit
+    void set_engine(EvolveEngine engine);
+    EvolveEngine engine() const;   // the engine evolve() will actually use
+    // Evolve bands in parallel on a pool owned by this grid; 1 (the default) is serial
+    void set_threads(size_t threads);
+    // Share an existing pool between grids; nullptr goes back to serial
+    void set_thread_pool(std::shared_ptr<ThreadPool> pool);
+    size_t threads() const;
+    // Only re-evaluate tiles that changed, or border one that changed, in the
+    // previous generation. Results are identical to full evaluation.
+    void set_active_tracking(bool enabled);
+    bool active_tracking() const;
+    const ActivityStats& activity() const;
+    // Record GenerationMetrics for each evolve(), keeping the last `history`.
+    // The counters come from the kernels as they store each word.
+    void set_metrics(bool enabled, size_t history = 1024);
+    bool metrics_enabled() const;
+    const GenerationMetrics& last_metrics() const;
+    std::vector<GenerationMetrics> metrics_history() const;   // oldest first
+    // Called with every generation's metrics, e.g. a MetricsLog; empty to stop
+    void set_metrics_sink(std::function<void(const GenerationMetrics&)> sink);
+    // Keep a Zobrist-style hash of the cells, updated from the words each
+    // generation changes, plus the last `history` hashes. A hash seen again is
+    // a cycle candidate; run() confirms it before relying on it.
+    void set_cycle_detection(bool enabled, size_t history = 256);
+    bool cycle_detection() const;
+    std::uint64_t hash() const;   // computed in full when detection is off
+    std::optional<GridCycle> cycle_candidate() const;
+    // Advance `generations` generations with cycle detection on. A candidate
+    // is confirmed by evolving one period and comparing the cells; then run()
+    // stops or skips ahead as `action` says. Skipping still ends with the
+    // cells and generation() of the full run.
+    RunResult run(std::uint64_t generations, CycleAction action = CycleAction::Skip);
     void set(size_t x, size_t y, CellState state);
     CellState at(size_t x, size_t y) const;
+    Neighborhood neighborhood(size_t x, size_t y) const;
     std::vector<CellState> get_neighborhood(size_t x, size_t y) const;
     void evolve();
+    std::uint64_t generation() const;   // evolve() calls so far
+
+    // Reproducible bulk fill. Cell (x, y) draws from a counter-based generator
+    // keyed on `seed` and its index, so the result depends only on the seed,
+    // never on the thread count. Cells are non-zero with probability `density`,
+    // and non-zero cells are uniform over [1, states).
+    void randomize(std::uint64_t seed, double density = 0.5, unsigned states = 16);
+    // weights[s] is the relative probability of state s; at most 16 entries
+    void randomize(std::uint64_t seed, std::span<const double> weights);
+
+    // Raw access for bulk I/O. replace_cells() takes over `cells` as the
+    // current generation and throws std::invalid_argument unless its
+    // dimensions and storage match this grid.
+    const CellBuffer& cells() const;
+    void replace_cells(CellBuffer cells, std::uint64_t generation);
+
+private:
+    AutomatonGrid(size_t w, size_t h, std::shared_ptr<const detail::RuleKernel> kernel,
+                  bool life_rule, CellStorage storage);
+    bool supports_bitsliced_life() const;
+    void schedule_tiles();
+    void evolve_band(size_t band, EvolveEngine engine);
+    void record_metrics(std::chrono::steady_clock::time_point start);
+    std::uint64_t full_hash() const;
+    void record_hash();
+    void restart_hash_history();
 };
+
+namespace detail {
+    // Calls `visitor` with the function object behind a built-in rule, so the
+    // rule can be inlined, or with the pointer itself for any other rule
+    template <typename Visitor>
+    auto visit_rule(AutomatonGrid::RuleFunction rule, Visitor&& visitor) {
+        if (rule == &rules::game_of_life_rule) return visitor(rules::GameOfLife{});
+        if (rule == &rules::cyclic_rule) return visitor(rules::Cyclic{});
+        if (rule == &rules::majority_rule) return visitor(rules::Majority{});
+        if (rule == &rules::xor_rule) return visitor(rules::Xor{});
+        return visitor(rule);
+    }
+}
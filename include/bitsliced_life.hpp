@@ -0,0 +1,43 @@
+#pragma once
+
+#include "automation.hpp"
+
+// Game of Life on 1-bit rows: 64 cells per word, neighbour counts built from
+// bit-parallel full adders. On x86-64 ELF targets the row kernel is compiled
+// for AVX-512, AVX2 and a portable baseline, and the loader picks the best one
+// at runtime; elsewhere only the portable build is used.
+namespace bitsliced_life {
+    // Next state for 64 cells from the 3x3 block of bitboards around them.
+    // rules::game_of_life_rule counts the centre cell along with its eight
+    // neighbours, so a cell is born on a total of 3 and survives on 2 or 3.
+    inline std::uint64_t life_word(std::uint64_t nw, std::uint64_t n, std::uint64_t ne,
+                                   std::uint64_t w, std::uint64_t c, std::uint64_t e,
+                                   std::uint64_t sw, std::uint64_t s, std::uint64_t se) {
+        // One full adder per row
+        std::uint64_t above_sum = nw ^ n ^ ne;
+        std::uint64_t above_carry = (nw & n) | (ne & (nw ^ n));
+        std::uint64_t middle_sum = w ^ c ^ e;
+        std::uint64_t middle_carry = (w & c) | (e & (w ^ c));
+        std::uint64_t below_sum = sw ^ s ^ se;
+        std::uint64_t below_carry = (sw & s) | (se & (sw ^ s));
+
+        // Weight-1 column
+        std::uint64_t ones = above_sum ^ middle_sum ^ below_sum;
+        std::uint64_t ones_carry = (above_sum & middle_sum) | (below_sum & (above_sum ^ middle_sum));
+
+        // Weight-2 column; anything spilling into weight 4 means a total of four or more
+        std::uint64_t pair = above_carry ^ middle_carry ^ below_carry;
+        std::uint64_t pair_carry = (above_carry & middle_carry) | (below_carry & (above_carry ^ middle_carry));
+        std::uint64_t twos = pair ^ ones_carry;
+        std::uint64_t fours = pair_carry | (pair & ones_carry);
+
+        // Total of 3, or a total of 2 on a live cell
+        return twos & ~fours & (ones | c);
+    }
+
+    // Advance words [w0, w1) of rows [y0, y1) of a toroidal `width` x `height`
+    // grid from `src` into `dst`, both in CellStorage::Bit. Returns true if any
+    // of those cells changed. A non-null `tally` counts the new words.
+    bool step_rows(const CellBuffer& src, CellBuffer& dst, size_t width, size_t height,
+                   size_t y0, size_t y1, size_t w0, size_t w1, detail::CellTally* tally = nullptr);
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "automation.hpp"
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+class ThreadPool;
+
+// Per-grid results reported by Ensemble::summarize()
+struct EnsembleSummary {
+    size_t grid;
+    std::uint64_t population;          // non-zero cells
+    std::uint64_t changed;             // cells that changed in the last generation
+    std::array<std::uint64_t, 16> histogram;
+};
+
+namespace detail {
+    // Batch stencil over rows [y0, y1) of every grid in an ensemble. Cell
+    // (x, y) of all `count` grids fills `lane_words` consecutive words, one
+    // byte per grid, or one bit per grid when lane_bits() is 1.
+    class EnsembleKernel {
+    public:
+        virtual ~EnsembleKernel() = default;
+        virtual unsigned lane_bits() const { return 8; }
+        virtual void evolve_rows(const std::uint64_t* src, std::uint64_t* dst, size_t count, size_t lane_words,
+                                 size_t width, size_t height, size_t y0, size_t y1) const = 0;
+    };
+
+    // Batch forms of the built-in multi-state rules: flat loops across the
+    // grids of one cell that the compiler can vectorise. Defined in ensemble.cpp.
+    void batch_cells(const rules::Cyclic&, const std::uint8_t* const* blocks, std::uint8_t* out, size_t count);
+    void batch_cells(const rules::Majority&, const std::uint8_t* const* blocks, std::uint8_t* out, size_t count);
+    void batch_cells(const rules::Xor&, const std::uint8_t* const* blocks, std::uint8_t* out, size_t count);
+
+    template <typename Rule>
+    concept BatchRule = requires(const Rule& rule, const std::uint8_t* const* blocks, std::uint8_t* out) {
+        batch_cells(rule, blocks, out, size_t{});
+    };
+
+    template <CellRule Rule>
+    class EnsembleKernelFor final : public EnsembleKernel {
+        Rule rule_;
+    public:
+        explicit EnsembleKernelFor(Rule rule) : rule_(std::move(rule)) {}
+
+        void evolve_rows(const std::uint64_t* src, std::uint64_t* dst, size_t count, size_t lane_words,
+                         size_t width, size_t height, size_t y0, size_t y1) const override {
+            const size_t cell_bytes = lane_words * sizeof(std::uint64_t);
+            const auto* in = reinterpret_cast<const std::uint8_t*>(src);
+            auto* next = reinterpret_cast<std::uint8_t*>(dst);
+            for (size_t y = y0; y < y1; ++y) {
+                const size_t ys[3] = { y == 0 ? height - 1 : y - 1, y, y + 1 == height ? 0 : y + 1 };
+                for (size_t x = 0; x < width; ++x) {
+                    const size_t xs[3] = { x == 0 ? width - 1 : x - 1, x, x + 1 == width ? 0 : x + 1 };
+
+                    // The nine neighbour cells, each a contiguous run of `count` grids
+                    const std::uint8_t* blocks[9];
+                    for (size_t dy = 0; dy < 3; ++dy) {
+                        for (size_t dx = 0; dx < 3; ++dx) {
+                            blocks[dy * 3 + dx] = in + (ys[dy] * width + xs[dx]) * cell_bytes;
+                        }
+                    }
+
+                    std::uint8_t* out = next + (y * width + x) * cell_bytes;
+                    if constexpr (BatchRule<Rule>) {
+                        batch_cells(rule_, blocks, out, count);
+                    } else {
+                        std::array<CellState, 9> window;
+                        for (size_t g = 0; g < count; ++g) {
+                            for (size_t k = 0; k < 9; ++k) {
+                                window[k] = CellState(blocks[k][g]);
+                            }
+                            out[g] = static_cast<std::uint8_t>(CellState(rule_(std::span<const CellState, 9>(window))).value());
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    // game_of_life_rule with 64 grids per word: the neighbours of a cell are
+    // whole words, so the bit-sliced adder runs with no shifting at all
+    class EnsembleLifeKernel final : public EnsembleKernel {
+    public:
+        unsigned lane_bits() const override { return 1; }
+        void evolve_rows(const std::uint64_t* src, std::uint64_t* dst, size_t count, size_t lane_words,
+                         size_t width, size_t height, size_t y0, size_t y1) const override;
+    };
+
+    template <CellRule Rule>
+    std::shared_ptr<const EnsembleKernel> make_ensemble_kernel(Rule rule) {
+        if constexpr (std::is_same_v<Rule, rules::GameOfLife>) {
+            return std::make_shared<const EnsembleLifeKernel>();
+        } else {
+            return std::make_shared<const EnsembleKernelFor<Rule>>(std::move(rule));
+        }
+    }
+}
+
+// A batch of independent toroidal grids with the same size and rule, evolved
+// together. Cells are stored structure-of-arrays: the values of cell (x, y)
+// for every grid are contiguous, so one pass of the stencil serves the whole
+// batch and the batch splits into row bands across a thread pool. Game of
+// Life batches keep one bit per grid and, like CellStorage::Bit, store any
+// non-zero state as 1; other rules keep a byte per grid.
+class Ensemble {
+public:
+    Ensemble(size_t count, size_t w, size_t h, AutomatonGrid::RuleFunction rule);
+    template <CellRule Rule>
+    Ensemble(size_t count, size_t w, size_t h, Rule rule)
+        : Ensemble(count, w, h, detail::make_ensemble_kernel(std::move(rule))) {}
+
+    size_t size() const;
+    std::pair<size_t, size_t> dimensions() const;
+    std::uint64_t generation() const;
+
+    CellState at(size_t grid, size_t x, size_t y) const;
+    void set(size_t grid, size_t x, size_t y, CellState state);
+    // Fills every grid with states uniform in [0, states); reproducible from
+    // `seed`. Throws std::invalid_argument unless states is in [1, 16].
+    void randomize(std::uint64_t seed, unsigned states = 16);
+
+    void set_threads(size_t threads);
+    void set_thread_pool(std::shared_ptr<ThreadPool> pool);
+    size_t threads() const;
+
+    void evolve(size_t generations = 1);
+
+    std::vector<EnsembleSummary> summarize() const;
+    // One CSV line per grid: grid, generation, population, changed, state_0..state_15
+    void write_summary(std::ostream& out) const;
+
+private:
+    Ensemble(size_t count, size_t w, size_t h, std::shared_ptr<const detail::EnsembleKernel> kernel);
+    unsigned value(const std::vector<std::uint64_t>& cells, size_t grid, size_t cell) const;
+
+    size_t count_, width_, height_;
+    std::shared_ptr<const detail::EnsembleKernel> kernel_;
+    unsigned lane_bits_;
+    size_t lane_words_;                 // words per cell, covering every grid
+    std::vector<std::uint64_t> cells_;
+    std::vector<std::uint64_t> back_;   // previous generation after evolve()
+    std::shared_ptr<ThreadPool> pool_;
+    std::uint64_t generation_ = 0;
+};
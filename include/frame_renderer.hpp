@@ -0,0 +1,67 @@
+#pragma once
+
+#include "automation.hpp"
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Draws an AutomatonGrid to a terminal as "# " / ". " pairs, one grid row per
+// terminal row. Each frame is composed into a buffer sized for a full redraw
+// up front, holds cursor moves and symbols for changed cells only, and goes
+// out in a single write().
+class FrameRenderer {
+public:
+    // `fd` is the file descriptor frames are written to (1 = stdout)
+    FrameRenderer(size_t width, size_t height, int fd = 1);
+
+    // The escape sequences for the next frame; `status` goes on the line
+    // below the grid and is only rewritten when it changes
+    std::string_view compose(const AutomatonGrid& grid, std::string_view status = {});
+    // compose() followed by a single write of the result
+    void render(const AutomatonGrid& grid, std::string_view status = {});
+    // Redraw every cell on the next frame, e.g. after the screen was cleared
+    void invalidate();
+
+private:
+    void move_to(size_t row, size_t column);
+    void append_number(size_t value);
+
+    size_t width_, height_;
+    int fd_;
+    std::vector<char> shown_;   // symbol currently on screen per cell, 0 if unknown
+    std::string status_;
+    std::string frame_;
+};
+
+// Decouples the simulation rate from the display rate. Deadlines that were
+// missed are dropped rather than queued, so a slow terminal costs frames, not
+// generations, and a slow simulation never triggers a burst of catch-up work.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // gps == 0 runs the simulation as fast as it will go; so would fps == 0,
+    // which makes wait() spin, so callers should keep fps above zero
+    FramePacer(double fps, double gps);
+
+    bool generation_due(Clock::time_point now) const;
+    bool frame_due(Clock::time_point now) const;
+    void generation_done(Clock::time_point now);
+    void frame_done(Clock::time_point now);
+    // Sleep until the next generation or frame is due
+    void wait(Clock::time_point now) const;
+
+    // Rates achieved over the last completed one-second window
+    double fps() const;
+    double gps() const;
+
+private:
+    void roll_window(Clock::time_point now);
+
+    Clock::duration frame_interval_, generation_interval_;
+    Clock::time_point next_frame_, next_generation_;
+    Clock::time_point window_start_;
+    size_t window_frames_ = 0, window_generations_ = 0;
+    double fps_ = 0, gps_ = 0;
+};
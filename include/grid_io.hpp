@@ -0,0 +1,67 @@
+#pragma once
+
+#include "automation.hpp"
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+// Persistence for AutomatonGrid.
+//
+// Snapshots are a 64-byte header followed by the grid's packed rows exactly as
+// CellBuffer holds them, in host byte order, so loading maps the file and uses
+// it in place. Pages are mapped copy-on-write: editing or evolving the loaded
+// grid never writes back to the file.
+//
+// RLE is the run-length pattern format used by Golly and LifeWiki. Dead cells
+// are 'b' or '.', live cells 'o', and states 1-15 are 'A'-'O'.
+namespace grid_io {
+    struct SnapshotHeader {
+        char magic[8];              // "CAGRID" padded with NULs
+        std::uint32_t version;
+        std::uint32_t bits_per_cell;
+        std::uint64_t width;
+        std::uint64_t height;
+        std::uint64_t generation;
+        std::uint64_t stride;       // 64-bit words per row
+        std::uint64_t reserved[2];
+    };
+    static_assert(sizeof(SnapshotHeader) == 64);
+
+    constexpr std::uint32_t snapshot_version = 1;
+
+    // Both throw std::runtime_error on I/O failure or a malformed file
+    void save_snapshot(const AutomatonGrid& grid, const std::string& path);
+    SnapshotHeader read_snapshot_header(const std::string& path);
+
+    // Maps the file's cells into `grid`, which must have been constructed with
+    // the dimensions and storage recorded in the header
+    void load_snapshot(const std::string& path, AutomatonGrid& grid);
+
+    template <typename Rule>
+    AutomatonGrid load_snapshot(const std::string& path, Rule rule) {
+        const SnapshotHeader header = read_snapshot_header(path);
+        AutomatonGrid grid(header.width, header.height, rule, static_cast<CellStorage>(header.bits_per_cell));
+        load_snapshot(path, grid);
+        return grid;
+    }
+
+    // Streams an RLE pattern into `grid` with its top-left corner at (x0, y0).
+    // Only live cells are written, so the cost follows the pattern, not the
+    // grid. Throws std::runtime_error on malformed input and std::out_of_range
+    // if the pattern does not fit.
+    void load_rle(std::istream& in, AutomatonGrid& grid, size_t x0 = 0, size_t y0 = 0);
+
+    // Consumes comment lines and the header line, returning the pattern size
+    std::pair<size_t, size_t> read_rle_size(std::istream& in);
+
+    // A grid sized to the pattern's "x = .., y = .." header
+    template <typename Rule>
+    AutomatonGrid read_rle(std::istream& in, Rule rule, CellStorage storage = CellStorage::Nibble) {
+        auto [width, height] = read_rle_size(in);
+        AutomatonGrid grid(width, height, rule, storage);
+        load_rle(in, grid);
+        return grid;
+    }
+
+    void write_rle(std::ostream& out, const AutomatonGrid& grid);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "automation.hpp"
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// HashLife for rules::game_of_life_rule: the plane is a hash-consed quadtree
+// and every macro-cell memoises its own future, so regular patterns can be
+// advanced by millions of generations in a handful of steps.
+//
+// Unlike AutomatonGrid the plane is unbounded rather than toroidal; the two
+// agree for as long as a pattern stays clear of the grid's edges.
+class HashLife {
+public:
+    static constexpr size_t default_max_nodes = size_t{1} << 22;
+
+    // Once a step leaves more than `max_nodes` nodes behind, nodes no longer
+    // reachable from the current pattern are collected. The limit is soft:
+    // collection only runs between steps, so a single large step can grow
+    // past it. A step that would need more node ids than NodeId can hold
+    // throws std::length_error.
+    explicit HashLife(size_t max_nodes = default_max_nodes);
+    // Copies the live cells of `grid`, with cell (x, y) landing at (x, y)
+    explicit HashLife(const AutomatonGrid& grid, size_t max_nodes = default_max_nodes);
+
+    CellState at(int64_t x, int64_t y) const;
+    void set(int64_t x, int64_t y, CellState state);
+
+    // Advance 2^log2_generations generations
+    void step(unsigned log2_generations);
+    // Advance an arbitrary number of generations, one power-of-two step per set bit
+    void advance(uint64_t generations);
+
+    uint64_t generation() const;
+    uint64_t population() const;
+    size_t node_count() const;
+    void collect_garbage();
+
+    // The window [x0, x0 + width) x [y0, y0 + height) as a toroidal grid
+    AutomatonGrid to_grid(size_t width, size_t height, int64_t x0 = 0, int64_t y0 = 0,
+                          CellStorage storage = CellStorage::Bit) const;
+
+private:
+    using NodeId = uint32_t;
+    static constexpr NodeId no_result = ~NodeId{0};
+
+    struct Node {
+        NodeId nw, ne, sw, se;
+        unsigned level;
+        uint64_t population;
+        NodeId result;   // centre advanced 2^step_log_ generations, if memoised
+    };
+
+    struct ChildrenHash {
+        size_t operator()(const std::array<NodeId, 4>& key) const;
+    };
+
+    NodeId make(NodeId nw, NodeId ne, NodeId sw, NodeId se);
+    NodeId empty(unsigned level);
+    NodeId expand(NodeId node);
+    NodeId centre(NodeId node);
+    NodeId successor(NodeId node);
+    NodeId base_successor(NodeId node);
+    bool cell(NodeId node, int64_t x, int64_t y) const;
+    NodeId set_cell(NodeId node, int64_t x, int64_t y, bool alive);
+    NodeId build(const AutomatonGrid& grid, unsigned level, int64_t x0, int64_t y0);
+    void copy_to(NodeId node, AutomatonGrid& grid, int64_t x, int64_t y,
+                 int64_t x0, int64_t y0, size_t width, size_t height) const;
+
+    std::vector<Node> nodes_;
+    std::unordered_map<std::array<NodeId, 4>, NodeId, ChildrenHash> index_;
+    std::vector<NodeId> empty_;   // empty_[level]
+    NodeId root_;
+    unsigned step_log_ = 0;
+    uint64_t generation_ = 0;
+    size_t max_nodes_;
+};
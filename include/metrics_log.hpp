@@ -0,0 +1,25 @@
+#pragma once
+
+#include "automation.hpp"
+#include <iosfwd>
+
+enum class MetricsFormat {
+    Csv,         // header line, then one row per generation
+    JsonLines    // one JSON object per line
+};
+
+// Streams GenerationMetrics as they are recorded. Pass one to
+// AutomatonGrid::set_metrics_sink; the stream is flushed every `flush_every`
+// generations so a tail -f on the file stays current.
+class MetricsLog {
+public:
+    MetricsLog(std::ostream& out, MetricsFormat format = MetricsFormat::Csv, size_t flush_every = 64);
+
+    void operator()(const GenerationMetrics& metrics);
+
+private:
+    std::ostream* out_;
+    MetricsFormat format_;
+    size_t flush_every_;
+    size_t pending_ = 0;
+};
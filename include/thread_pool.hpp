@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent work-stealing pool. Each thread owns a task deque: it pops from
+// the back of its own and steals from the front of the others' when it runs dry.
+class ThreadPool {
+public:
+    // `threads` counts the calling thread, so ThreadPool(4) starts three workers
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const;
+
+    // Runs body(i) for every i in [0, count) and returns once all calls have
+    // finished. The calling thread takes part; the first exception is rethrown.
+    void parallel_for(size_t count, const std::function<void(size_t)>& body);
+
+private:
+    struct Batch {
+        const std::function<void(size_t)>* body;
+        size_t remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+
+    struct Task {
+        Batch* batch;
+        size_t index;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool try_pop(size_t self, Task& task);
+    void run(const Task& task);
+    void worker_loop(size_t self);
+
+    std::vector<std::unique_ptr<Queue>> queues_;   // queues_[0] is fed to the calling thread
+    std::vector<std::jthread> workers_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_{0};
+    bool stopping_ = false;
+};
@@ -1,86 +1,597 @@
 #include "automation.hpp"
+#include "bitsliced_life.hpp"
+#include "thread_pool.hpp"
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <stdexcept>
+#include <string>
 
 // Move function definitions here
-CellState::CellState(unsigned val) : value_(val % 16) {}
-unsigned CellState::value() const { return value_; }
 void CellState::set_value(unsigned val) { value_ = val % 16; }
 void CellState::randomize() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<unsigned> dis(0, 15);
+    thread_local std::mt19937 gen(std::random_device{}());
+    std::uniform_int_distribution<unsigned> dis(0, 15);
     value_ = dis(gen);
 }
 
+// CellBuffer Implementations
+CellBuffer::CellBuffer(size_t w, size_t h, CellStorage storage)
+    : width_(w), height_(h), bits_(static_cast<unsigned>(storage)),
+      stride_((w * bits_ + 63) / 64), words_(stride_ * h, 0), data_(words_.data()) {}
+
+CellBuffer::CellBuffer(size_t w, size_t h, CellStorage storage, std::uint64_t* words, std::shared_ptr<void> owner)
+    : width_(w), height_(h), bits_(static_cast<unsigned>(storage)),
+      stride_((w * bits_ + 63) / 64), owner_(std::move(owner)), data_(words) {}
+
+CellBuffer::CellBuffer(const CellBuffer& other)
+    : width_(other.width_), height_(other.height_), bits_(other.bits_), stride_(other.stride_),
+      words_(other.data_, other.data_ + other.size_words()), data_(words_.data()) {}
+
+CellBuffer& CellBuffer::operator=(const CellBuffer& other) {
+    if (this != &other) {
+        CellBuffer copy(other);
+        swap(copy);
+    }
+    return *this;
+}
+
+unsigned CellBuffer::get(size_t x, size_t y) const {
+    switch (bits_) {
+        case 1: return load<1>(row(y), x);
+        case 4: return load<4>(row(y), x);
+        default: return load<32>(row(y), x);
+    }
+}
+
+void CellBuffer::put(size_t x, size_t y, unsigned value) {
+    const size_t per_word = 64 / bits_;
+    const std::uint64_t mask = (std::uint64_t{1} << bits_) - 1;
+    const unsigned shift = static_cast<unsigned>((x % per_word) * bits_);
+    if (bits_ == 1) {
+        value = value != 0;
+    }
+    std::uint64_t& word = row(y)[x / per_word];
+    word = (word & ~(mask << shift)) | ((std::uint64_t{value} & mask) << shift);
+}
+
+void CellBuffer::swap(CellBuffer& other) noexcept {
+    std::swap(width_, other.width_);
+    std::swap(height_, other.height_);
+    std::swap(bits_, other.bits_);
+    std::swap(stride_, other.stride_);
+    words_.swap(other.words_);
+    owner_.swap(other.owner_);
+    std::swap(data_, other.data_);
+}
+
 // AutomatonGrid Implementations
-AutomatonGrid::AutomatonGrid(size_t w, size_t h, RuleFunction rule)
-    : width_(w), height_(h), rule_(rule), grid_(w * h, CellState(0)) {}
+namespace {
+    std::shared_ptr<const detail::RuleKernel> make_kernel(AutomatonGrid::RuleFunction rule) {
+        return detail::visit_rule(rule, [](auto inlined) -> std::shared_ptr<const detail::RuleKernel> {
+            return std::make_shared<const detail::RuleKernelFor<decltype(inlined)>>(inlined);
+        });
+    }
+}
+
+AutomatonGrid::AutomatonGrid(size_t w, size_t h, RuleFunction rule, CellStorage storage)
+    : AutomatonGrid(w, h, make_kernel(rule), rule == &rules::game_of_life_rule, storage) {}
+
+AutomatonGrid::AutomatonGrid(size_t w, size_t h, std::shared_ptr<const detail::RuleKernel> kernel,
+                             bool life_rule, CellStorage storage)
+    : width_(w), height_(h), kernel_(std::move(kernel)), life_rule_(life_rule), storage_(storage),
+      grid_(w, h, storage), back_(w, h, storage),
+      tiles_x_((w + tile_size - 1) / tile_size), tiles_y_((h + tile_size - 1) / tile_size),
+      band_tallies_(tiles_y_) {}
 
 std::pair<size_t, size_t> AutomatonGrid::dimensions() const { return {width_, height_}; }
-void AutomatonGrid::set(size_t x, size_t y, CellState state) { grid_[y * width_ + x] = state; }
-CellState AutomatonGrid::at(size_t x, size_t y) const { return grid_[y * width_ + x]; }
+CellStorage AutomatonGrid::storage() const { return storage_; }
 
-std::vector<CellState> AutomatonGrid::get_neighborhood(size_t x, size_t y) const {
-    std::vector<CellState> neighbors;
-    for (int dy = -1; dy <= 1; ++dy) {
-        for (int dx = -1; dx <= 1; ++dx) {
-            size_t nx = (x + dx + width_) % width_;
-            size_t ny = (y + dy + height_) % height_;
-            neighbors.push_back(grid_[ny * width_ + nx]);
+void AutomatonGrid::set_engine(EvolveEngine engine) {
+    if (engine == EvolveEngine::BitSlicedLife && !supports_bitsliced_life()) {
+        throw std::invalid_argument("bit-sliced engine requires game_of_life_rule with CellStorage::Bit");
+    }
+    engine_ = engine;
+}
+
+EvolveEngine AutomatonGrid::engine() const {
+    if (engine_ == EvolveEngine::Auto) {
+        return supports_bitsliced_life() ? EvolveEngine::BitSlicedLife : EvolveEngine::Stencil;
+    }
+    return engine_;
+}
+
+void AutomatonGrid::set_threads(size_t threads) {
+    pool_ = threads > 1 ? std::make_shared<ThreadPool>(threads) : nullptr;
+}
+
+void AutomatonGrid::set_thread_pool(std::shared_ptr<ThreadPool> pool) { pool_ = std::move(pool); }
+size_t AutomatonGrid::threads() const { return pool_ ? pool_->size() : 1; }
+
+void AutomatonGrid::set_active_tracking(bool enabled) {
+    track_activity_ = enabled;
+    // Everything counts as changed until a generation has been evaluated in full
+    changed_.assign(enabled ? tiles_x_ * tiles_y_ : 0, 1);
+    active_.assign(enabled ? tiles_x_ * tiles_y_ : 0, 1);
+    tile_histograms_.assign(enabled && metrics_enabled_ ? tiles_x_ * tiles_y_ : 0, {});
+    activity_ = {};
+}
+
+bool AutomatonGrid::active_tracking() const { return track_activity_; }
+const ActivityStats& AutomatonGrid::activity() const { return activity_; }
+
+std::uint64_t GenerationMetrics::population() const {
+    std::uint64_t live = 0;
+    for (size_t s = 1; s < histogram.size(); ++s) {
+        live += histogram[s];
+    }
+    return live;
+}
+
+void AutomatonGrid::set_metrics(bool enabled, size_t history) {
+    metrics_enabled_ = enabled;
+    tile_histograms_.assign(enabled && track_activity_ ? tiles_x_ * tiles_y_ : 0, {});
+    metrics_history_.assign(enabled ? history : 0, {});
+    metrics_recorded_ = 0;
+    last_metrics_ = {};
+    // Skipped tiles reuse their last histogram, so every tile is counted once first
+    if (track_activity_) {
+        std::fill(changed_.begin(), changed_.end(), 1);
+    }
+}
+
+bool AutomatonGrid::metrics_enabled() const { return metrics_enabled_; }
+const GenerationMetrics& AutomatonGrid::last_metrics() const { return last_metrics_; }
+
+std::vector<GenerationMetrics> AutomatonGrid::metrics_history() const {
+    const size_t capacity = metrics_history_.size();
+    const size_t kept = std::min(metrics_recorded_, capacity);
+    std::vector<GenerationMetrics> history;
+    history.reserve(kept);
+    for (size_t i = metrics_recorded_ - kept; i < metrics_recorded_; ++i) {
+        history.push_back(metrics_history_[i % capacity]);
+    }
+    return history;
+}
+
+void AutomatonGrid::set_metrics_sink(std::function<void(const GenerationMetrics&)> sink) {
+    metrics_sink_ = std::move(sink);
+}
+
+void AutomatonGrid::record_metrics(std::chrono::steady_clock::time_point start) {
+    detail::CellTally total;
+    for (const auto& band : band_tallies_) {
+        total.merge(band);
+    }
+
+    GenerationMetrics metrics;
+    metrics.generation = generation_;
+    metrics.cells_evaluated = total.evaluated;
+    metrics.cells_changed = total.changed;
+    metrics.histogram = total.histogram;
+    metrics.histogram[0] = width_ * height_ - metrics.population();
+    metrics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    last_metrics_ = metrics;
+    if (!metrics_history_.empty()) {
+        metrics_history_[metrics_recorded_ % metrics_history_.size()] = metrics;
+    }
+    ++metrics_recorded_;
+    if (metrics_sink_) {
+        metrics_sink_(metrics);
+    }
+}
+
+bool AutomatonGrid::supports_bitsliced_life() const {
+    return life_rule_ && storage_ == CellStorage::Bit;
+}
+
+void AutomatonGrid::set(size_t x, size_t y, CellState state) {
+    if (hashing_) {
+        const size_t word = x / (64 / grid_.bits());
+        const std::uint64_t before = grid_.row(y)[word];
+        grid_.put(x, y, state.value());
+        const std::uint64_t seed = zobrist_seeds_[y * grid_.stride() + word];
+        hash_ ^= detail::zobrist_word(seed, before) ^ detail::zobrist_word(seed, grid_.row(y)[word]);
+        restart_hash_history();
+    } else {
+        grid_.put(x, y, state.value());
+    }
+    if (track_activity_) {
+        changed_[(y / tile_size) * tiles_x_ + x / tile_size] = 1;
+    }
+}
+
+CellState AutomatonGrid::at(size_t x, size_t y) const { return CellState(grid_.get(x, y)); }
+
+AutomatonGrid::Neighborhood AutomatonGrid::neighborhood(size_t x, size_t y) const {
+    const size_t xs[3] = { x == 0 ? width_ - 1 : x - 1, x, x + 1 == width_ ? 0 : x + 1 };
+    const size_t ys[3] = { y == 0 ? height_ - 1 : y - 1, y, y + 1 == height_ ? 0 : y + 1 };
+
+    Neighborhood neighbors;
+    for (size_t dy = 0; dy < 3; ++dy) {
+        for (size_t dx = 0; dx < 3; ++dx) {
+            neighbors[dy * 3 + dx] = CellState(grid_.get(xs[dx], ys[dy]));
         }
     }
     return neighbors;
 }
 
+std::vector<CellState> AutomatonGrid::get_neighborhood(size_t x, size_t y) const {
+    auto neighbors = neighborhood(x, y);
+    return {neighbors.begin(), neighbors.end()};
+}
+
+// Bands only read grid_ and write their own rows of back_, and every row starts
+// on a fresh word, so they need no synchronisation and the result is the same
+// whatever order or thread they run on.
 void AutomatonGrid::evolve() {
-    std::vector<CellState> new_grid = grid_;
-    for (size_t y = 0; y < height_; ++y) {
-        for (size_t x = 0; x < width_; ++x) {
-            auto neighbors = get_neighborhood(x, y);
-            new_grid[y * width_ + x] = rule_(neighbors);
+    const auto start = metrics_enabled_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    if (track_activity_) {
+        schedule_tiles();
+    }
+    if (metrics_enabled_ || hashing_) {
+        std::fill(band_tallies_.begin(), band_tallies_.end(),
+                  detail::CellTally{.count_cells = metrics_enabled_, .zobrist_seeds = hashing_ ? zobrist_seeds_.data() : nullptr});
+    }
+
+    const EvolveEngine active = engine();
+    if (pool_ && pool_->size() > 1 && tiles_y_ > 1) {
+        pool_->parallel_for(tiles_y_, [this, active](size_t band) { evolve_band(band, active); });
+    } else {
+        for (size_t band = 0; band < tiles_y_; ++band) {
+            evolve_band(band, active);
+        }
+    }
+    grid_.swap(back_);
+    ++generation_;
+    if (metrics_enabled_) {
+        record_metrics(start);
+    }
+    if (hashing_) {
+        for (const auto& band : band_tallies_) {
+            hash_ ^= band.hash;
         }
+        record_hash();
     }
-    grid_ = std::move(new_grid);
 }
 
-// Define the missing `rules` functions
-namespace rules {
-    CellState game_of_life_rule(std::span<const CellState> neighborhood) {
-        int live_neighbors = std::count_if(neighborhood.begin(), neighborhood.end(),
-            [](const CellState& cell) { return cell.value() > 0; });
+std::uint64_t AutomatonGrid::generation() const { return generation_; }
+const CellBuffer& AutomatonGrid::cells() const { return grid_; }
+
+void AutomatonGrid::replace_cells(CellBuffer cells, std::uint64_t generation) {
+    if (cells.width() != width_ || cells.height() != height_ ||
+        cells.bits() != static_cast<unsigned>(storage_)) {
+        throw std::invalid_argument("cell buffer does not match the grid's dimensions or storage");
+    }
+    grid_ = std::move(cells);
+    generation_ = generation;
+    if (track_activity_) {
+        std::fill(changed_.begin(), changed_.end(), 1);
+    }
+    if (hashing_) {
+        hash_ = full_hash();
+        restart_hash_history();
+    }
+}
 
-        bool is_alive = neighborhood[4].value() > 0;
+namespace {
+    // Maps a 32-bit draw to a state: the number of cumulative thresholds it
+    // reaches. Most values of the draw's top byte fall wholly inside one
+    // state, so `buckets` answers those directly and only the few buckets a
+    // threshold cuts through fall back to a binary search.
+    struct FillTable {
+        static constexpr std::uint8_t straddles = 0xff;
+        std::array<std::uint64_t, 15> thresholds;   // non-decreasing
+        unsigned count = 0;
+        std::array<std::uint8_t, 256> buckets;
 
-        if (is_alive) {
-            return CellState((live_neighbors == 2 || live_neighbors == 3) ? 1 : 0);
-        } else {
-            return CellState(live_neighbors == 3 ? 1 : 0);
+        unsigned search(std::uint64_t draw) const {
+            return static_cast<unsigned>(std::upper_bound(thresholds.begin(), thresholds.begin() + count, draw) - thresholds.begin());
+        }
+        unsigned state(std::uint64_t draw) const {
+            const std::uint8_t bucket = buckets[draw >> 24];
+            return bucket != straddles ? bucket : search(draw);
+        }
+    };
+
+    // Rows start on a fresh word, so each band assembles and stores whole words
+    // without touching another band's memory. Each 64-bit draw serves a pair of
+    // cells, and pairs never straddle rows.
+    template <unsigned Bits>
+    void fill_rows(CellBuffer& cells, size_t width, size_t y0, size_t y1, std::uint64_t seed, const FillTable& table) {
+        constexpr size_t per_word = 64 / Bits;
+        const size_t pairs_per_row = (width + 1) / 2;
+        // Bit storage only keeps zero / non-zero, which is the first threshold alone
+        const FillTable local = table;
+        const std::uint64_t alive_from = local.count != 0 ? local.thresholds[0] : std::uint64_t{1} << 32;
+        auto state_of = [&local, alive_from](std::uint64_t draw) -> std::uint64_t {
+            if constexpr (Bits == 1) {
+                return draw >= alive_from;
+            } else {
+                return local.state(draw);
+            }
+        };
+
+        for (size_t y = y0; y < y1; ++y) {
+            std::uint64_t* words = cells.row(y);
+            for (size_t x0 = 0; x0 < width; x0 += per_word) {
+                const size_t x1 = std::min(width, x0 + per_word);
+                std::uint64_t word = 0;
+                for (size_t x = x0; x < x1; x += 2) {
+                    const std::uint64_t draw = detail::counter_random(seed, y * pairs_per_row + x / 2);
+                    word |= state_of(draw & 0xffffffff) << ((x - x0) * Bits);
+                    if (x + 1 < x1) {
+                        word |= state_of(draw >> 32) << ((x + 1 - x0) * Bits);
+                    }
+                }
+                words[x0 / per_word] = word;
+            }
+        }
+    }
+}
+
+void AutomatonGrid::randomize(std::uint64_t seed, double density, unsigned states) {
+    if (density < 0 || density > 1 || states < 2 || states > 16) {
+        throw std::invalid_argument("density must be in [0, 1] and states in [2, 16]");
+    }
+    std::array<double, 16> weights{};
+    weights[0] = 1 - density;
+    std::fill(weights.begin() + 1, weights.begin() + states, density / (states - 1));
+    randomize(seed, std::span<const double>(weights.data(), states));
+}
+
+void AutomatonGrid::randomize(std::uint64_t seed, std::span<const double> weights) {
+    double total = 0;
+    for (double weight : weights) {
+        if (!(weight >= 0)) {
+            throw std::invalid_argument("state weights must be non-negative");
+        }
+        total += weight;
+    }
+    if (weights.empty() || weights.size() > 16 || !(total > 0)) {
+        throw std::invalid_argument("need 1 to 16 state weights with a positive sum");
+    }
+
+    // A cell's state is the number of thresholds its 32-bit draw reaches
+    constexpr double scale = 4294967296.0;   // 2^32
+    FillTable table;
+    double cumulative = 0;
+    for (; table.count + 1 < weights.size(); ++table.count) {
+        cumulative += weights[table.count];
+        table.thresholds[table.count] = static_cast<std::uint64_t>(std::min(cumulative / total, 1.0) * scale);
+    }
+    for (std::uint64_t bucket = 0; bucket < table.buckets.size(); ++bucket) {
+        const unsigned low = table.search(bucket << 24);
+        const unsigned high = table.search(((bucket + 1) << 24) - 1);
+        table.buckets[bucket] = low == high ? static_cast<std::uint8_t>(low) : FillTable::straddles;
+    }
+
+    auto fill_band = [&](size_t band) {
+        const size_t y0 = band * tile_size, y1 = std::min(height_, y0 + tile_size);
+        switch (grid_.bits()) {
+            case 1: return fill_rows<1>(grid_, width_, y0, y1, seed, table);
+            case 4: return fill_rows<4>(grid_, width_, y0, y1, seed, table);
+            default: return fill_rows<32>(grid_, width_, y0, y1, seed, table);
+        }
+    };
+    if (pool_ && pool_->size() > 1 && tiles_y_ > 1) {
+        pool_->parallel_for(tiles_y_, fill_band);
+    } else {
+        for (size_t band = 0; band < tiles_y_; ++band) {
+            fill_band(band);
+        }
+    }
+    if (track_activity_) {
+        std::fill(changed_.begin(), changed_.end(), 1);
+    }
+    if (hashing_) {
+        hash_ = full_hash();
+        restart_hash_history();
+    }
+}
+
+void AutomatonGrid::set_cycle_detection(bool enabled, size_t history) {
+    hashing_ = enabled;
+    // Per-word seeds turn each key update in the evolve pass into a single mix
+    zobrist_seeds_ = std::vector<std::uint64_t>(enabled ? grid_.size_words() : 0);
+    for (size_t i = 0; i < zobrist_seeds_.size(); ++i) {
+        zobrist_seeds_[i] = detail::zobrist_seed(i);
+    }
+    hash_ = enabled ? full_hash() : 0;
+    hash_history_.assign(enabled ? std::max<size_t>(history, 1) : 0, {});
+    restart_hash_history();
+}
+
+bool AutomatonGrid::cycle_detection() const { return hashing_; }
+std::uint64_t AutomatonGrid::hash() const { return hashing_ ? hash_ : full_hash(); }
+std::optional<GridCycle> AutomatonGrid::cycle_candidate() const { return cycle_candidate_; }
+
+std::uint64_t AutomatonGrid::full_hash() const {
+    std::uint64_t hash = 0;
+    for (size_t i = 0; i < grid_.size_words(); ++i) {
+        const std::uint64_t seed = hashing_ ? zobrist_seeds_[i] : detail::zobrist_seed(i);
+        hash ^= detail::zobrist_word(seed, grid_.data()[i]);
+    }
+    return hash;
+}
+
+// The history only describes an unbroken run of evolve() calls, so anything
+// that edits the cells starts it again from the current state
+void AutomatonGrid::restart_hash_history() {
+    hashes_recorded_ = 0;
+    cycle_candidate_.reset();
+    if (hashing_) {
+        record_hash();
+    }
+}
+
+// The most recent earlier generation with the same hash gives the shortest period
+void AutomatonGrid::record_hash() {
+    const size_t capacity = hash_history_.size();
+    const size_t kept = std::min(hashes_recorded_, capacity);
+    cycle_candidate_.reset();
+    for (size_t i = hashes_recorded_; i > hashes_recorded_ - kept; --i) {
+        const auto& [generation, hash] = hash_history_[(i - 1) % capacity];
+        if (hash == hash_) {
+            cycle_candidate_ = GridCycle{generation, generation_ - generation};
+            break;
         }
     }
+    hash_history_[hashes_recorded_ % capacity] = {generation_, hash_};
+    ++hashes_recorded_;
+}
+
+RunResult AutomatonGrid::run(std::uint64_t generations, CycleAction action) {
+    if (!hashing_) {
+        set_cycle_detection(true);
+    }
+    RunResult result;
+    const std::uint64_t target = generation_ + generations;
+    auto step = [&] {
+        evolve();
+        ++result.evolved;
+    };
+
+    while (generation_ < target) {
+        step();
+        if (!cycle_candidate_) {
+            continue;
+        }
 
-    CellState cyclic_rule(std::span<const CellState> neighborhood) {
-        unsigned next_state = (neighborhood[4].value() + 1) % 16;
-        bool should_change = std::any_of(neighborhood.begin(), neighborhood.end(),
-            [next_state](const CellState& cell) { return cell.value() == next_state; });
+        // Equal hashes can collide, so replay one period and compare the cells
+        const GridCycle candidate = *cycle_candidate_;
+        const CellBuffer seen = grid_;
+        const std::uint64_t confirm_at = generation_ + candidate.period;
+        while (generation_ < confirm_at && generation_ < target) {
+            step();
+        }
+        if (generation_ != confirm_at ||
+            !std::equal(seen.data(), seen.data() + seen.size_words(), grid_.data())) {
+            continue;
+        }
 
-        return CellState(should_change ? next_state : neighborhood[4].value());
+        result.cycle = candidate;
+        if (action == CycleAction::Stop) {
+            break;
+        }
+        for (std::uint64_t i = (target - generation_) % candidate.period; i > 0; --i) {
+            step();
+        }
+        // Same cells as generation `target`; the history no longer lines up with it
+        generation_ = target;
+        restart_hash_history();
+        break;
     }
+    return result;
+}
 
-    CellState majority_rule(std::span<const CellState> neighborhood) {
-        std::vector<int> count(16, 0);
-        for (const auto& cell : neighborhood) {
-            count[cell.value()]++;
+// A tile can only change if it or one of its eight neighbours changed last
+// generation. A tile that is skipped did not change last generation either, so
+// back_ already holds its current contents and needs no copy.
+void AutomatonGrid::schedule_tiles() {
+    activity_ = {tiles_x_ * tiles_y_, 0, 0};
+    for (size_t ty = 0; ty < tiles_y_; ++ty) {
+        const size_t rows[3] = { ty == 0 ? tiles_y_ - 1 : ty - 1, ty, ty + 1 == tiles_y_ ? 0 : ty + 1 };
+        for (size_t tx = 0; tx < tiles_x_; ++tx) {
+            const size_t cols[3] = { tx == 0 ? tiles_x_ - 1 : tx - 1, tx, tx + 1 == tiles_x_ ? 0 : tx + 1 };
+            std::uint8_t active = 0;
+            for (size_t r : rows) {
+                for (size_t c : cols) {
+                    active |= changed_[r * tiles_x_ + c];
+                }
+            }
+            active_[ty * tiles_x_ + tx] = active;
+            activity_.tiles_evaluated += active;
         }
-        int max_state = std::distance(count.begin(), std::max_element(count.begin(), count.end()));
-        return CellState(max_state);
     }
+    activity_.tiles_skipped = activity_.tiles - activity_.tiles_evaluated;
+}
+
+void AutomatonGrid::evolve_band(size_t band, EvolveEngine engine) {
+    const size_t y0 = band * tile_size;
+    const size_t y1 = std::min(height_, y0 + tile_size);
+
+    detail::CellTally* tally = metrics_enabled_ || hashing_ ? &band_tallies_[band] : nullptr;
 
-    CellState xor_rule(std::span<const CellState> neighborhood) {
-        unsigned new_state = 0;
-        for (const auto& cell : neighborhood) {
-            new_state ^= cell.value();
+    auto evolve_tile = [&](size_t x0, size_t x1, detail::CellTally* counts) {
+        if (engine == EvolveEngine::BitSlicedLife) {
+            return bitsliced_life::step_rows(grid_, back_, width_, height_, y0, y1,
+                                             x0 / 64, (x1 + 63) / 64, counts);
         }
-        return CellState(new_state % 16);
+        bool changed = false;
+        for (size_t y = y0; y < y1; ++y) {
+            changed |= kernel_->evolve_row(grid_, back_, width_, height_, y, x0, x1, counts);
+        }
+        return changed;
+    };
+
+    if (!track_activity_) {
+        evolve_tile(0, width_, tally);
+        return;
+    }
+
+    for (size_t tx = 0; tx < tiles_x_; ++tx) {
+        const size_t tile = band * tiles_x_ + tx;
+        const size_t x0 = tx * tile_size;
+        if (!metrics_enabled_) {
+            changed_[tile] = active_[tile] && evolve_tile(x0, std::min(width_, x0 + tile_size), tally);
+            continue;
+        }
+        // A skipped tile holds the same cells as last time it was counted
+        detail::CellTally counts{.count_cells = true, .zobrist_seeds = hashing_ ? zobrist_seeds_.data() : nullptr};
+        changed_[tile] = active_[tile] && evolve_tile(x0, std::min(width_, x0 + tile_size), &counts);
+        if (active_[tile]) {
+            tile_histograms_[tile] = counts.histogram;
+        }
+        counts.histogram = tile_histograms_[tile];
+        tally->merge(counts);
     }
 }
 
+// Define the missing `rules` functions
+namespace rules {
+    CellState game_of_life_rule(std::span<const CellState> neighborhood) { return GameOfLife{}(neighborhood); }
+    CellState cyclic_rule(std::span<const CellState> neighborhood) { return Cyclic{}(neighborhood); }
+    CellState majority_rule(std::span<const CellState> neighborhood) { return Majority{}(neighborhood); }
+    CellState xor_rule(std::span<const CellState> neighborhood) { return Xor{}(neighborhood); }
+
+    LifeLike::LifeLike(std::string_view rulestring) {
+        // Neighbour counts (centre excluded) that cause a birth or survival
+        std::array<bool, 9> birth{}, survival{};
+        auto digits = [&](std::string_view part, std::array<bool, 9>& counts) {
+            for (char c : part) {
+                if (c < '0' || c > '8') {
+                    throw std::invalid_argument("invalid rulestring: " + std::string(rulestring));
+                }
+                counts[c - '0'] = true;
+            }
+        };
+
+        const size_t slash = rulestring.find('/');
+        if (slash == std::string_view::npos) {
+            throw std::invalid_argument("invalid rulestring: " + std::string(rulestring));
+        }
+        std::string_view first = rulestring.substr(0, slash), second = rulestring.substr(slash + 1);
+        auto tagged = [](std::string_view part, char tag) {
+            return !part.empty() && (part[0] == tag || part[0] == tag + ('a' - 'A'));
+        };
+        if (tagged(first, 'B') && tagged(second, 'S')) {
+            digits(first.substr(1), birth);
+            digits(second.substr(1), survival);
+        } else if (tagged(first, 'S') && tagged(second, 'B')) {
+            digits(first.substr(1), survival);
+            digits(second.substr(1), birth);
+        } else {
+            // Classic "survival/birth" notation
+            digits(first, survival);
+            digits(second, birth);
+        }
+
+        for (unsigned index = 0; index < table_.size(); ++index) {
+            const bool alive = index & (1u << 4);
+            const int neighbours = std::popcount(index & ~(1u << 4));
+            table_[index] = alive ? survival[neighbours] : birth[neighbours];
+        }
+    }
+}
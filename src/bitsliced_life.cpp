@@ -0,0 +1,101 @@
+#include "bitsliced_life.hpp"
+#include <algorithm>
+#include <bit>
+
+// target_clones dispatches through an ifunc, which only ELF targets support;
+// MinGW and macOS get the portable build
+#if defined(__x86_64__) && defined(__ELF__) && (defined(__GNUC__) || defined(__clang__))
+#define LIFE_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#define TALLY_TARGET_CLONES __attribute__((target_clones("popcnt", "default")))
+#else
+#define LIFE_TARGET_CLONES
+#define TALLY_TARGET_CLONES
+#endif
+
+namespace {
+    using bitsliced_life::life_word;
+
+    LIFE_TARGET_CLONES
+    bool step_row(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                  std::uint64_t* out, size_t words, size_t width, size_t w0, size_t w1) {
+        const size_t last = words - 1;
+        const unsigned last_bit = static_cast<unsigned>((width - 1) % 64);
+        const std::uint64_t last_mask = last_bit == 63 ? ~std::uint64_t{0} : (std::uint64_t{2} << last_bit) - 1;
+
+        // Neighbour words for the first and last word of the row, where the torus wraps
+        auto west = [&](const std::uint64_t* r, size_t i) {
+            std::uint64_t carry = i == 0 ? (r[last] >> last_bit) & 1 : r[i - 1] >> 63;
+            return (r[i] << 1) | carry;
+        };
+        auto east = [&](const std::uint64_t* r, size_t i) {
+            return i == last ? (r[i] >> 1) | ((r[0] & 1) << last_bit)
+                             : (r[i] >> 1) | (r[i + 1] << 63);
+        };
+        auto edge = [&](size_t i) {
+            std::uint64_t next = life_word(west(above, i), above[i], east(above, i),
+                                           west(row, i), row[i], east(row, i),
+                                           west(below, i), below[i], east(below, i));
+            return i == last ? next & last_mask : next;
+        };
+
+        std::uint64_t changed = 0;
+        if (w0 == 0) {
+            out[0] = edge(0);
+            changed |= out[0] ^ row[0];
+        }
+        const size_t begin = std::max<size_t>(w0, 1), end = std::min(w1, last);
+        for (size_t i = begin; i < end; ++i) {
+            out[i] = life_word((above[i] << 1) | (above[i - 1] >> 63), above[i], (above[i] >> 1) | (above[i + 1] << 63),
+                               (row[i] << 1) | (row[i - 1] >> 63), row[i], (row[i] >> 1) | (row[i + 1] << 63),
+                               (below[i] << 1) | (below[i - 1] >> 63), below[i], (below[i] >> 1) | (below[i + 1] << 63));
+            changed |= out[i] ^ row[i];
+        }
+        if (w1 == words && last != 0) {
+            out[last] = edge(last);
+            changed |= out[last] ^ row[last];
+        }
+        return changed != 0;
+    }
+
+    // Baseline x86-64 has no popcnt instruction, so this gets its own clone.
+    // `base` is the buffer index of word 0 of the row.
+    TALLY_TARGET_CLONES
+    void tally_row(const std::uint64_t* before, const std::uint64_t* after, size_t base,
+                   size_t w0, size_t w1, detail::CellTally& tally) {
+        if (tally.count_cells) {
+            std::uint64_t changed = 0, live = 0;
+            for (size_t i = w0; i < w1; ++i) {
+                changed += std::popcount(before[i] ^ after[i]);
+                live += std::popcount(after[i]);
+            }
+            tally.changed += changed;
+            tally.histogram[1] += live;
+        }
+        if (tally.zobrist_seeds) {
+            const std::uint64_t* seeds = tally.zobrist_seeds + base;
+            for (size_t i = w0; i < w1; ++i) {
+                if (before[i] != after[i]) {
+                    tally.hash ^= detail::zobrist_word(seeds[i], before[i]) ^ detail::zobrist_word(seeds[i], after[i]);
+                }
+            }
+        }
+    }
+}
+
+namespace bitsliced_life {
+    bool step_rows(const CellBuffer& src, CellBuffer& dst, size_t width, size_t height,
+                   size_t y0, size_t y1, size_t w0, size_t w1, detail::CellTally* tally) {
+        bool changed = false;
+        for (size_t y = y0; y < y1; ++y) {
+            changed |= step_row(src.row(y == 0 ? height - 1 : y - 1), src.row(y),
+                                src.row(y + 1 == height ? 0 : y + 1), dst.row(y),
+                                src.stride(), width, w0, w1);
+            if (tally) {
+                // Count the row while it is still in L1
+                tally_row(src.row(y), dst.row(y), y * src.stride(), w0, w1, *tally);
+                tally->evaluated += std::min(width, w1 * 64) - w0 * 64;
+            }
+        }
+        return changed;
+    }
+}
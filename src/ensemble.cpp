@@ -0,0 +1,198 @@
+#include "ensemble.hpp"
+#include "bitsliced_life.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+
+namespace detail {
+    // Cells never hold more than 15, so byte arithmetic is exact. Stores to
+    // `out` may alias anything, so each loop works on a local copy of the
+    // block pointers, which lets the compiler keep them in registers and
+    // vectorise across grids.
+    void batch_cells(const rules::Cyclic&, const std::uint8_t* const* blocks, std::uint8_t* out, size_t count) {
+        const std::uint8_t* block[9];
+        std::copy_n(blocks, 9, block);
+        for (size_t g = 0; g < count; ++g) {
+            const std::uint8_t centre = block[4][g];
+            const std::uint8_t next = (centre + 1) & 15;
+            std::uint8_t change = 0;
+            for (size_t k = 0; k < 9; ++k) {
+                change |= block[k][g] == next;
+            }
+            out[g] = change ? next : centre;
+        }
+    }
+
+    // The winning state is one of the nine present, so each is counted
+    // against the others instead of tallying all sixteen states
+    void batch_cells(const rules::Majority&, const std::uint8_t* const* blocks, std::uint8_t* out, size_t count) {
+        const std::uint8_t* block[9];
+        std::copy_n(blocks, 9, block);
+        for (size_t g = 0; g < count; ++g) {
+            std::uint8_t cells[9];
+            for (size_t k = 0; k < 9; ++k) {
+                cells[k] = block[k][g];
+            }
+            std::uint8_t best = 0, best_count = 0;
+            for (size_t k = 0; k < 9; ++k) {
+                std::uint8_t matches = 0;
+                for (size_t j = 0; j < 9; ++j) {
+                    matches += cells[j] == cells[k];
+                }
+                // Ties go to the lowest state
+                const bool better = matches > best_count || (matches == best_count && cells[k] < best);
+                best = better ? cells[k] : best;
+                best_count = better ? matches : best_count;
+            }
+            out[g] = best;
+        }
+    }
+
+    void batch_cells(const rules::Xor&, const std::uint8_t* const* blocks, std::uint8_t* out, size_t count) {
+        const std::uint8_t* block[9];
+        std::copy_n(blocks, 9, block);
+        for (size_t g = 0; g < count; ++g) {
+            std::uint8_t state = 0;
+            for (size_t k = 0; k < 9; ++k) {
+                state ^= block[k][g];
+            }
+            out[g] = state;
+        }
+    }
+
+    void EnsembleLifeKernel::evolve_rows(const std::uint64_t* src, std::uint64_t* dst, size_t, size_t lane_words,
+                                         size_t width, size_t height, size_t y0, size_t y1) const {
+        for (size_t y = y0; y < y1; ++y) {
+            const std::uint64_t* rows[3] = {
+                src + (y == 0 ? height - 1 : y - 1) * width * lane_words,
+                src + y * width * lane_words,
+                src + (y + 1 == height ? 0 : y + 1) * width * lane_words
+            };
+            std::uint64_t* out = dst + y * width * lane_words;
+            for (size_t x = 0; x < width; ++x) {
+                const size_t west = (x == 0 ? width - 1 : x - 1) * lane_words;
+                const size_t centre = x * lane_words;
+                const size_t east = (x + 1 == width ? 0 : x + 1) * lane_words;
+                // Unused lanes stay zero: an empty neighbourhood never comes alive
+                for (size_t i = 0; i < lane_words; ++i) {
+                    out[centre + i] = bitsliced_life::life_word(
+                        rows[0][west + i], rows[0][centre + i], rows[0][east + i],
+                        rows[1][west + i], rows[1][centre + i], rows[1][east + i],
+                        rows[2][west + i], rows[2][centre + i], rows[2][east + i]);
+                }
+            }
+        }
+    }
+}
+
+Ensemble::Ensemble(size_t count, size_t w, size_t h, AutomatonGrid::RuleFunction rule)
+    : Ensemble(count, w, h, detail::visit_rule(rule, [](auto inlined) {
+          return detail::make_ensemble_kernel(inlined);
+      })) {}
+
+Ensemble::Ensemble(size_t count, size_t w, size_t h, std::shared_ptr<const detail::EnsembleKernel> kernel)
+    : count_(count), width_(w), height_(h), kernel_(std::move(kernel)), lane_bits_(kernel_->lane_bits()),
+      lane_words_((count * lane_bits_ + 63) / 64), cells_(lane_words_ * w * h, 0), back_(lane_words_ * w * h, 0) {}
+
+size_t Ensemble::size() const { return count_; }
+std::pair<size_t, size_t> Ensemble::dimensions() const { return {width_, height_}; }
+std::uint64_t Ensemble::generation() const { return generation_; }
+
+unsigned Ensemble::value(const std::vector<std::uint64_t>& cells, size_t grid, size_t cell) const {
+    if (lane_bits_ == 1) {
+        return (cells[cell * lane_words_ + grid / 64] >> (grid % 64)) & 1;
+    }
+    return reinterpret_cast<const std::uint8_t*>(cells.data() + cell * lane_words_)[grid];
+}
+
+CellState Ensemble::at(size_t grid, size_t x, size_t y) const { return CellState(value(cells_, grid, y * width_ + x)); }
+
+void Ensemble::set(size_t grid, size_t x, size_t y, CellState state) {
+    const size_t cell = y * width_ + x;
+    if (lane_bits_ == 1) {
+        std::uint64_t& word = cells_[cell * lane_words_ + grid / 64];
+        const std::uint64_t bit = std::uint64_t{1} << (grid % 64);
+        word = state.value() != 0 ? word | bit : word & ~bit;
+    } else {
+        reinterpret_cast<std::uint8_t*>(cells_.data() + cell * lane_words_)[grid] = static_cast<std::uint8_t>(state.value());
+    }
+}
+
+void Ensemble::randomize(std::uint64_t seed, unsigned states) {
+    if (states < 1 || states > 16) {
+        throw std::invalid_argument("states must be in [1, 16]");
+    }
+    // Counter-based, so every cell is drawn independently in storage order
+    const size_t cells = width_ * height_;
+    for (size_t i = 0; i < cells; ++i) {
+        for (size_t g = 0; g < count_; ++g) {
+            const std::uint64_t draw = detail::counter_random(seed, g * cells + i) >> 32;
+            set(g, i % width_, i / width_, CellState(static_cast<unsigned>((draw * states) >> 32)));
+        }
+    }
+}
+
+void Ensemble::set_threads(size_t threads) {
+    pool_ = threads > 1 ? std::make_shared<ThreadPool>(threads) : nullptr;
+}
+
+void Ensemble::set_thread_pool(std::shared_ptr<ThreadPool> pool) { pool_ = std::move(pool); }
+size_t Ensemble::threads() const { return pool_ ? pool_->size() : 1; }
+
+void Ensemble::evolve(size_t generations) {
+    // Enough bands to balance the pool without making them tiny
+    const size_t rows_per_band = std::max<size_t>(1, height_ / (4 * threads()));
+    const size_t bands = (height_ + rows_per_band - 1) / rows_per_band;
+    auto band = [this, rows_per_band](size_t b) {
+        const size_t y0 = b * rows_per_band;
+        kernel_->evolve_rows(cells_.data(), back_.data(), count_, lane_words_, width_, height_,
+                             y0, std::min(height_, y0 + rows_per_band));
+    };
+
+    for (size_t i = 0; i < generations; ++i) {
+        if (pool_ && pool_->size() > 1 && bands > 1) {
+            pool_->parallel_for(bands, band);
+        } else {
+            for (size_t b = 0; b < bands; ++b) {
+                band(b);
+            }
+        }
+        cells_.swap(back_);
+        ++generation_;
+    }
+}
+
+std::vector<EnsembleSummary> Ensemble::summarize() const {
+    std::vector<EnsembleSummary> summaries(count_);
+    for (size_t g = 0; g < count_; ++g) {
+        summaries[g] = {g, 0, 0, {}};
+    }
+    // back_ holds the previous generation once at least one step has run
+    const bool has_previous = generation_ > 0;
+    for (size_t cell = 0; cell < width_ * height_; ++cell) {
+        for (size_t g = 0; g < count_; ++g) {
+            const unsigned current = value(cells_, g, cell);
+            auto& summary = summaries[g];
+            summary.histogram[current]++;
+            summary.population += current != 0;
+            summary.changed += has_previous && current != value(back_, g, cell);
+        }
+    }
+    return summaries;
+}
+
+void Ensemble::write_summary(std::ostream& out) const {
+    out << "grid,generation,population,changed";
+    for (int state = 0; state < 16; ++state) {
+        out << ",state_" << state;
+    }
+    out << '\n';
+    for (const auto& summary : summarize()) {
+        out << summary.grid << ',' << generation_ << ',' << summary.population << ',' << summary.changed;
+        for (auto count : summary.histogram) {
+            out << ',' << count;
+        }
+        out << '\n';
+    }
+}
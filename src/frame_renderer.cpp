@@ -0,0 +1,150 @@
+#include "frame_renderer.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Longest cursor move: ESC [ row ; column H with 20-digit numbers
+    constexpr size_t max_move = 2 + 20 + 1 + 20 + 1;
+}
+
+FrameRenderer::FrameRenderer(size_t width, size_t height, int fd)
+    : width_(width), height_(height), fd_(fd), shown_(width * height, 0) {
+    status_.reserve(256);
+    // Worst case is a cursor move for every cell plus the status line
+    frame_.reserve(width * height * (max_move + 2) + 2 * max_move + 256);
+}
+
+void FrameRenderer::invalidate() {
+    std::fill(shown_.begin(), shown_.end(), 0);
+    status_.clear();
+}
+
+std::string_view FrameRenderer::compose(const AutomatonGrid& grid, std::string_view status) {
+    auto [width, height] = grid.dimensions();
+    if (width != width_ || height != height_) {
+        throw std::invalid_argument("grid does not match the renderer's dimensions");
+    }
+
+    frame_.clear();
+    for (size_t y = 0; y < height_; ++y) {
+        // Column the cursor is known to be at in this row, if any
+        size_t cursor = SIZE_MAX;
+        for (size_t x = 0; x < width_; ++x) {
+            const char symbol = grid.at(x, y).value() > 0 ? '#' : '.';
+            char& shown = shown_[y * width_ + x];
+            if (shown == symbol) {
+                continue;
+            }
+            if (cursor != x) {
+                move_to(y + 1, 2 * x + 1);
+            }
+            frame_ += symbol;
+            frame_ += ' ';
+            shown = symbol;
+            cursor = x + 1;
+        }
+    }
+
+    if (status != status_) {
+        move_to(height_ + 1, 1);
+        frame_.append(status);
+        frame_ += "\x1b[K";     // clear whatever the previous status left behind
+        status_.assign(status);
+    }
+    return frame_;
+}
+
+void FrameRenderer::render(const AutomatonGrid& grid, std::string_view status) {
+    std::string_view bytes = compose(grid, status);
+#if defined(_WIN32)
+    std::fwrite(bytes.data(), 1, bytes.size(), stdout);
+    std::fflush(stdout);
+#else
+    while (!bytes.empty()) {
+        const ssize_t written = ::write(fd_, bytes.data(), bytes.size());
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("failed to write frame");
+        }
+        bytes.remove_prefix(static_cast<size_t>(written));
+    }
+#endif
+}
+
+void FrameRenderer::move_to(size_t row, size_t column) {
+    frame_ += "\x1b[";
+    append_number(row);
+    frame_ += ';';
+    append_number(column);
+    frame_ += 'H';
+}
+
+void FrameRenderer::append_number(size_t value) {
+    char digits[20];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    frame_.append(digits, result.ptr);
+}
+
+namespace {
+    FramePacer::Clock::duration interval(double rate) {
+        using namespace std::chrono;
+        return rate > 0 ? duration_cast<FramePacer::Clock::duration>(duration<double>(1.0 / rate))
+                        : FramePacer::Clock::duration::zero();
+    }
+}
+
+FramePacer::FramePacer(double fps, double gps)
+    : frame_interval_(interval(fps)), generation_interval_(interval(gps)),
+      next_frame_(Clock::now()), next_generation_(next_frame_), window_start_(next_frame_) {}
+
+bool FramePacer::generation_due(Clock::time_point now) const { return now >= next_generation_; }
+bool FramePacer::frame_due(Clock::time_point now) const { return now >= next_frame_; }
+
+void FramePacer::generation_done(Clock::time_point now) {
+    ++window_generations_;
+    next_generation_ += generation_interval_;
+    if (next_generation_ <= now) {
+        next_generation_ = now + generation_interval_;
+    }
+    roll_window(now);
+}
+
+void FramePacer::frame_done(Clock::time_point now) {
+    ++window_frames_;
+    next_frame_ += frame_interval_;
+    if (next_frame_ <= now) {
+        next_frame_ = now + frame_interval_;
+    }
+    roll_window(now);
+}
+
+void FramePacer::wait(Clock::time_point now) const {
+    const auto next = std::min(next_frame_, next_generation_);
+    if (next > now) {
+        std::this_thread::sleep_for(next - now);
+    }
+}
+
+double FramePacer::fps() const { return fps_; }
+double FramePacer::gps() const { return gps_; }
+
+void FramePacer::roll_window(Clock::time_point now) {
+    const std::chrono::duration<double> elapsed = now - window_start_;
+    if (elapsed.count() >= 1.0) {
+        fps_ = static_cast<double>(window_frames_) / elapsed.count();
+        gps_ = static_cast<double>(window_generations_) / elapsed.count();
+        window_frames_ = window_generations_ = 0;
+        window_start_ = now;
+    }
+}
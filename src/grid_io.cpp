@@ -0,0 +1,290 @@
+#include "grid_io.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr char snapshot_magic[8] = {'C', 'A', 'G', 'R', 'I', 'D', 0, 0};
+
+    void validate(const grid_io::SnapshotHeader& header, const std::string& path) {
+        if (std::memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) != 0) {
+            throw std::runtime_error(path + ": not a grid snapshot");
+        }
+        if (header.version != grid_io::snapshot_version) {
+            throw std::runtime_error(path + ": unsupported snapshot version " + std::to_string(header.version));
+        }
+        if (header.bits_per_cell != 1 && header.bits_per_cell != 4 && header.bits_per_cell != 32) {
+            throw std::runtime_error(path + ": unsupported bits per cell");
+        }
+        // The file size check works on stride * height * 8, so neither product may wrap
+        constexpr std::uint64_t max_size = std::numeric_limits<size_t>::max();
+        if (header.width == 0 || header.height == 0 ||
+            header.width > (max_size - 63) / header.bits_per_cell ||
+            header.stride != (header.width * header.bits_per_cell + 63) / 64 ||
+            header.stride > (max_size - sizeof(grid_io::SnapshotHeader)) / sizeof(std::uint64_t) / header.height) {
+            throw std::runtime_error(path + ": inconsistent snapshot dimensions");
+        }
+    }
+
+    char rle_tag(unsigned state, bool multi_state) {
+        if (multi_state) {
+            return state == 0 ? '.' : static_cast<char>('A' + state - 1);
+        }
+        return state == 0 ? 'b' : 'o';
+    }
+
+    std::pair<size_t, size_t> parse_rle_header(const std::string& line) {
+        size_t width = 0, height = 0;
+        bool has_width = false, has_height = false;
+        size_t pos = 0;
+        while (pos < line.size()) {
+            size_t end = line.find(',', pos);
+            if (end == std::string::npos) {
+                end = line.size();
+            }
+            const std::string field = line.substr(pos, end - pos);
+            const size_t eq = field.find('=');
+            if (eq != std::string::npos) {
+                std::string key;
+                for (char c : field.substr(0, eq)) {
+                    if (!std::isspace(static_cast<unsigned char>(c))) key += c;
+                }
+                try {
+                    if (key == "x") { width = std::stoull(field.substr(eq + 1)); has_width = true; }
+                    if (key == "y") { height = std::stoull(field.substr(eq + 1)); has_height = true; }
+                } catch (const std::exception&) {
+                    throw std::runtime_error("malformed RLE header: " + line);
+                }
+            }
+            pos = end + 1;
+        }
+        if (!has_width || !has_height) {
+            throw std::runtime_error("malformed RLE header: " + line);
+        }
+        return {width, height};
+    }
+
+    void skip_rle_comments(std::istream& in) {
+        std::string line;
+        while (in >> std::ws && in.peek() == '#') {
+            std::getline(in, line);
+        }
+    }
+}
+
+namespace grid_io {
+    void save_snapshot(const AutomatonGrid& grid, const std::string& path) {
+        const CellBuffer& cells = grid.cells();
+        SnapshotHeader header{};
+        std::memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+        header.version = snapshot_version;
+        header.bits_per_cell = cells.bits();
+        header.width = cells.width();
+        header.height = cells.height();
+        header.generation = grid.generation();
+        header.stride = cells.stride();
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(cells.data()),
+                  static_cast<std::streamsize>(cells.size_words() * sizeof(std::uint64_t)));
+        out.close();
+        if (!out) {
+            throw std::runtime_error(path + ": failed to write snapshot");
+        }
+    }
+
+    SnapshotHeader read_snapshot_header(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        SnapshotHeader header{};
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            throw std::runtime_error(path + ": failed to read snapshot header");
+        }
+        validate(header, path);
+        return header;
+    }
+
+    void load_snapshot(const std::string& path, AutomatonGrid& grid) {
+        const SnapshotHeader header = read_snapshot_header(path);
+        const auto storage = static_cast<CellStorage>(header.bits_per_cell);
+        const size_t data_bytes = header.stride * header.height * sizeof(std::uint64_t);
+
+#if defined(_WIN32)
+        CellBuffer cells(header.width, header.height, storage);
+        std::ifstream in(path, std::ios::binary);
+        in.seekg(sizeof(SnapshotHeader));
+        if (!in.read(reinterpret_cast<char*>(cells.data()), static_cast<std::streamsize>(data_bytes))) {
+            throw std::runtime_error(path + ": snapshot is truncated");
+        }
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(path + ": failed to open snapshot");
+        }
+        struct stat info{};
+        const size_t file_bytes = sizeof(SnapshotHeader) + data_bytes;
+        if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < file_bytes) {
+            ::close(fd);
+            throw std::runtime_error(path + ": snapshot is truncated");
+        }
+        // Private and writable: the grid may edit its cells, but only its own
+        // copy-on-write pages ever change
+        void* mapping = ::mmap(nullptr, file_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error(path + ": failed to map snapshot");
+        }
+        std::shared_ptr<void> owner(mapping, [file_bytes](void* p) { ::munmap(p, file_bytes); });
+        auto* words = reinterpret_cast<std::uint64_t*>(static_cast<char*>(mapping) + sizeof(SnapshotHeader));
+        CellBuffer cells(header.width, header.height, storage, words, std::move(owner));
+#endif
+        grid.replace_cells(std::move(cells), header.generation);
+    }
+
+    std::pair<size_t, size_t> read_rle_size(std::istream& in) {
+        skip_rle_comments(in);
+        std::string line;
+        if (in.peek() != 'x' || !std::getline(in, line)) {
+            throw std::runtime_error("RLE pattern has no header line");
+        }
+        return parse_rle_header(line);
+    }
+
+    void load_rle(std::istream& in, AutomatonGrid& grid, size_t x0, size_t y0) {
+        auto [width, height] = grid.dimensions();
+        skip_rle_comments(in);
+        if (in.peek() == 'x') {
+            auto [pattern_width, pattern_height] = read_rle_size(in);
+            if (x0 + pattern_width > width || y0 + pattern_height > height) {
+                throw std::out_of_range("RLE pattern does not fit in the grid");
+            }
+        }
+
+        size_t x = 0, y = 0, count = 0;
+        char c;
+        while (in.get(c)) {
+            if (std::isdigit(static_cast<unsigned char>(c))) {
+                count = count * 10 + static_cast<size_t>(c - '0');
+                continue;
+            }
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                continue;
+            }
+
+            const size_t run = count == 0 ? 1 : count;
+            count = 0;
+            unsigned state = 0;
+            if (c == 'b' || c == '.') {
+                x += run;
+                continue;
+            } else if (c == '$') {
+                y += run;
+                x = 0;
+                continue;
+            } else if (c == '!') {
+                return;
+            } else if (c == 'o') {
+                state = 1;
+            } else if (c >= 'A' && c <= 'O') {
+                state = static_cast<unsigned>(c - 'A' + 1);
+            } else {
+                throw std::runtime_error(std::string("unsupported RLE tag '") + c + "'");
+            }
+
+            if (x0 + x + run > width || y0 + y >= height) {
+                throw std::out_of_range("RLE pattern does not fit in the grid");
+            }
+            for (size_t i = 0; i < run; ++i) {
+                grid.set(x0 + x + i, y0 + y, CellState(state));
+            }
+            x += run;
+        }
+    }
+
+    void write_rle(std::ostream& out, const AutomatonGrid& grid) {
+        const CellBuffer& cells = grid.cells();
+        auto [width, height] = grid.dimensions();
+        const size_t per_word = 64 / cells.bits();
+
+        bool multi_state = false;
+        for (size_t y = 0; y < height && !multi_state && cells.bits() > 1; ++y) {
+            for (size_t x = 0; x < width && !multi_state; ++x) {
+                multi_state = cells.get(x, y) > 1;
+            }
+        }
+
+        out << "x = " << width << ", y = " << height << "\n";
+        constexpr size_t max_line = 70;
+        size_t line_length = 0;
+        auto emit = [&](size_t run, char tag) {
+            std::string token = run > 1 ? std::to_string(run) : std::string();
+            token += tag;
+            if (line_length + token.size() > max_line) {
+                out << '\n';
+                line_length = 0;
+            }
+            out << token;
+            line_length += token.size();
+        };
+
+        size_t last_row = 0;
+        for (size_t y = 0; y < height; ++y) {
+            const std::uint64_t* row = cells.row(y);
+            size_t run = 0, x = 0;
+            unsigned run_state = 0;
+            bool row_started = false;
+
+            auto flush = [&](unsigned next_state) {
+                if (run > 0 && !(run_state == 0 && next_state == ~0u)) {
+                    if (!row_started && y > last_row) {
+                        emit(y - last_row, '$');
+                    }
+                    row_started = true;
+                    emit(run, rle_tag(run_state, multi_state));
+                }
+            };
+
+            while (x < width) {
+                // Whole empty words are the common case in sparse patterns
+                if (x % per_word == 0 && row[x / per_word] == 0) {
+                    const size_t span = std::min(per_word, width - x);
+                    if (run_state != 0) {
+                        flush(0);
+                        run_state = 0;
+                        run = 0;
+                    }
+                    run += span;
+                    x += span;
+                    continue;
+                }
+                const unsigned state = cells.get(x, y);
+                if (state != run_state) {
+                    flush(state);
+                    run_state = state;
+                    run = 0;
+                }
+                ++run;
+                ++x;
+            }
+            flush(~0u);    // trailing dead cells are implied by the row end
+            if (row_started) {
+                last_row = y;
+            }
+        }
+        emit(1, '!');
+        out << '\n';
+    }
+}
@@ -0,0 +1,321 @@
+#include "hashlife.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+size_t HashLife::ChildrenHash::operator()(const std::array<NodeId, 4>& key) const {
+    uint64_t h = 0x9e3779b97f4a7c15ull;
+    for (NodeId id : key) {
+        h = (h ^ id) * 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 31;
+    }
+    return static_cast<size_t>(h);
+}
+
+HashLife::HashLife(size_t max_nodes) : max_nodes_(max_nodes) {
+    // Leaves: node 0 is a dead cell, node 1 a live one
+    nodes_.push_back({0, 0, 0, 0, 0, 0, no_result});
+    nodes_.push_back({0, 0, 0, 0, 0, 1, no_result});
+    empty_.push_back(0);
+    root_ = empty(3);
+}
+
+HashLife::HashLife(const AutomatonGrid& grid, size_t max_nodes) : HashLife(max_nodes) {
+    auto [width, height] = grid.dimensions();
+    unsigned level = 3;
+    while ((int64_t{1} << (level - 1)) < static_cast<int64_t>(std::max(width, height))) {
+        ++level;
+    }
+    // The root is centred on the origin, so the grid fills its south-east quadrant
+    const NodeId e = empty(level - 1);
+    root_ = make(e, e, e, build(grid, level - 1, 0, 0));
+}
+
+CellState HashLife::at(int64_t x, int64_t y) const {
+    const int64_t half = int64_t{1} << (nodes_[root_].level - 1);
+    if (x < -half || x >= half || y < -half || y >= half) {
+        return CellState(0);
+    }
+    return CellState(cell(root_, x + half, y + half) ? 1 : 0);
+}
+
+void HashLife::set(int64_t x, int64_t y, CellState state) {
+    int64_t half = int64_t{1} << (nodes_[root_].level - 1);
+    while (x < -half || x >= half || y < -half || y >= half) {
+        root_ = expand(root_);
+        half <<= 1;
+    }
+    root_ = set_cell(root_, x + half, y + half, state.value() != 0);
+}
+
+void HashLife::step(unsigned log2_generations) {
+    if (log2_generations > 60) {
+        throw std::invalid_argument("HashLife::step supports at most 2^60 generations at once");
+    }
+    if (log2_generations != step_log_) {
+        // Nodes at or below level k + 2 always advance 2^(level - 2) generations,
+        // so only the memo entries above the smaller of the two step sizes go stale
+        const unsigned keep = std::min(log2_generations, step_log_) + 2;
+        for (auto& node : nodes_) {
+            if (node.level > keep) {
+                node.result = no_result;
+            }
+        }
+        step_log_ = log2_generations;
+    }
+
+    // Light speed is one cell per generation, so a pattern inside the inner
+    // quarter cannot escape the centre half that successor() returns
+    while (nodes_[root_].level < step_log_ + 3 ||
+           nodes_[centre(centre(root_))].population != nodes_[root_].population) {
+        root_ = expand(root_);
+    }
+    root_ = successor(root_);
+    generation_ += uint64_t{1} << step_log_;
+
+    if (nodes_.size() > max_nodes_) {
+        collect_garbage();
+    }
+}
+
+void HashLife::advance(uint64_t generations) {
+    for (unsigned bit = 0; generations != 0; ++bit, generations >>= 1) {
+        if (generations & 1) {
+            step(bit);
+        }
+    }
+}
+
+uint64_t HashLife::generation() const { return generation_; }
+uint64_t HashLife::population() const { return nodes_[root_].population; }
+size_t HashLife::node_count() const { return nodes_.size(); }
+
+// Mark everything reachable from the root, then compact. Children are always
+// created before their parents, so a single forward pass can remap ids.
+void HashLife::collect_garbage() {
+    std::vector<bool> live(nodes_.size(), false);
+    std::vector<NodeId> stack(empty_.begin(), empty_.end());
+    stack.push_back(root_);
+    stack.push_back(1);
+    while (!stack.empty()) {
+        NodeId id = stack.back();
+        stack.pop_back();
+        if (live[id]) {
+            continue;
+        }
+        live[id] = true;
+        if (nodes_[id].level > 0) {
+            const Node& node = nodes_[id];
+            stack.insert(stack.end(), {node.nw, node.ne, node.sw, node.se});
+        }
+    }
+
+    std::vector<NodeId> remap(nodes_.size(), no_result);
+    std::vector<Node> kept;
+    kept.reserve(std::count(live.begin(), live.end(), true));
+    for (NodeId id = 0; id < nodes_.size(); ++id) {
+        if (!live[id]) {
+            continue;
+        }
+        Node node = nodes_[id];
+        if (node.level > 0) {
+            node.nw = remap[node.nw];
+            node.ne = remap[node.ne];
+            node.sw = remap[node.sw];
+            node.se = remap[node.se];
+        }
+        node.result = no_result;
+        remap[id] = static_cast<NodeId>(kept.size());
+        kept.push_back(node);
+    }
+    // Memoised results are created after the node that holds them, so they are
+    // remapped once every survivor has its new id
+    for (NodeId id = 0; id < nodes_.size(); ++id) {
+        if (live[id] && nodes_[id].result != no_result && live[nodes_[id].result]) {
+            kept[remap[id]].result = remap[nodes_[id].result];
+        }
+    }
+
+    nodes_ = std::move(kept);
+    index_.clear();
+    for (NodeId id = 2; id < nodes_.size(); ++id) {
+        const Node& node = nodes_[id];
+        index_.emplace(std::array<NodeId, 4>{node.nw, node.ne, node.sw, node.se}, id);
+    }
+    for (auto& id : empty_) {
+        id = remap[id];
+    }
+    root_ = remap[root_];
+}
+
+AutomatonGrid HashLife::to_grid(size_t width, size_t height, int64_t x0, int64_t y0,
+                                CellStorage storage) const {
+    AutomatonGrid grid(width, height, rules::game_of_life_rule, storage);
+    const int64_t half = int64_t{1} << (nodes_[root_].level - 1);
+    copy_to(root_, grid, -half, -half, x0, y0, width, height);
+    return grid;
+}
+
+HashLife::NodeId HashLife::make(NodeId nw, NodeId ne, NodeId sw, NodeId se) {
+    std::array<NodeId, 4> key{nw, ne, sw, se};
+    if (auto it = index_.find(key); it != index_.end()) {
+        return it->second;
+    }
+    const uint64_t population = nodes_[nw].population + nodes_[ne].population +
+                                nodes_[sw].population + nodes_[se].population;
+    // no_result is reserved, so it is the first id that cannot be handed out
+    if (nodes_.size() >= no_result) {
+        throw std::length_error("HashLife node ids exhausted; lower the step size or collect more often");
+    }
+    const NodeId id = static_cast<NodeId>(nodes_.size());
+    nodes_.push_back({nw, ne, sw, se, nodes_[nw].level + 1, population, no_result});
+    index_.emplace(key, id);
+    return id;
+}
+
+HashLife::NodeId HashLife::empty(unsigned level) {
+    while (empty_.size() <= level) {
+        const NodeId e = empty_.back();
+        empty_.push_back(make(e, e, e, e));
+    }
+    return empty_[level];
+}
+
+HashLife::NodeId HashLife::expand(NodeId node) {
+    const Node n = nodes_[node];
+    const NodeId e = empty(n.level - 1);
+    return make(make(e, e, e, n.nw), make(e, e, n.ne, e),
+                make(e, n.sw, e, e), make(n.se, e, e, e));
+}
+
+HashLife::NodeId HashLife::centre(NodeId node) {
+    const Node n = nodes_[node];
+    return make(nodes_[n.nw].se, nodes_[n.ne].sw, nodes_[n.sw].ne, nodes_[n.se].nw);
+}
+
+// The centre half of `node` advanced 2^min(step_log_, level - 2) generations
+HashLife::NodeId HashLife::successor(NodeId node) {
+    if (nodes_[node].result != no_result) {
+        return nodes_[node].result;
+    }
+
+    const Node n = nodes_[node];
+    NodeId result;
+    if (n.population == 0) {
+        result = empty(n.level - 1);
+    } else if (n.level == 2) {
+        result = base_successor(node);
+    } else {
+        const Node a = nodes_[n.nw], b = nodes_[n.ne], c = nodes_[n.sw], d = nodes_[n.se];
+
+        // Nine overlapping sub-squares one level down
+        const NodeId sub[9] = {
+            n.nw,                          make(a.ne, b.nw, a.se, b.sw), n.ne,
+            make(a.sw, a.se, c.nw, c.ne),  make(a.se, b.sw, c.ne, d.nw), make(b.sw, b.se, d.nw, d.ne),
+            n.sw,                          make(c.ne, d.nw, c.se, d.sw), n.se
+        };
+
+        // At full speed both halves of the step advance; otherwise only the second does
+        const bool full_speed = step_log_ + 2 >= n.level;
+        NodeId r[9];
+        for (int i = 0; i < 9; ++i) {
+            r[i] = full_speed ? successor(sub[i]) : centre(sub[i]);
+        }
+
+        result = make(successor(make(r[0], r[1], r[3], r[4])),
+                      successor(make(r[1], r[2], r[4], r[5])),
+                      successor(make(r[3], r[4], r[6], r[7])),
+                      successor(make(r[4], r[5], r[7], r[8])));
+    }
+
+    nodes_[node].result = result;
+    return result;
+}
+
+// One generation of the centre 2x2 of a 4x4 node, using the same totals as
+// rules::game_of_life_rule: born on 3, survives on 2 or 3, centre included
+HashLife::NodeId HashLife::base_successor(NodeId node) {
+    int cells[4][4];
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            cells[y][x] = cell(node, x, y);
+        }
+    }
+
+    NodeId next[4];
+    for (int y = 1; y <= 2; ++y) {
+        for (int x = 1; x <= 2; ++x) {
+            int total = 0;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    total += cells[y + dy][x + dx];
+                }
+            }
+            const bool alive = total == 3 || (cells[y][x] && total == 2);
+            next[(y - 1) * 2 + (x - 1)] = alive ? 1 : 0;
+        }
+    }
+    return make(next[0], next[1], next[2], next[3]);
+}
+
+bool HashLife::cell(NodeId node, int64_t x, int64_t y) const {
+    while (nodes_[node].level > 0) {
+        const Node& n = nodes_[node];
+        const int64_t half = int64_t{1} << (n.level - 1);
+        const bool east = x >= half, south = y >= half;
+        node = south ? (east ? n.se : n.sw) : (east ? n.ne : n.nw);
+        x -= east ? half : 0;
+        y -= south ? half : 0;
+    }
+    return node == 1;
+}
+
+HashLife::NodeId HashLife::set_cell(NodeId node, int64_t x, int64_t y, bool alive) {
+    const Node n = nodes_[node];
+    if (n.level == 0) {
+        return alive ? 1 : 0;
+    }
+    const int64_t half = int64_t{1} << (n.level - 1);
+    const bool east = x >= half, south = y >= half;
+    const int64_t cx = east ? x - half : x, cy = south ? y - half : y;
+    if (south) {
+        return east ? make(n.nw, n.ne, n.sw, set_cell(n.se, cx, cy, alive))
+                    : make(n.nw, n.ne, set_cell(n.sw, cx, cy, alive), n.se);
+    }
+    return east ? make(n.nw, set_cell(n.ne, cx, cy, alive), n.sw, n.se)
+                : make(set_cell(n.nw, cx, cy, alive), n.ne, n.sw, n.se);
+}
+
+HashLife::NodeId HashLife::build(const AutomatonGrid& grid, unsigned level, int64_t x0, int64_t y0) {
+    auto [width, height] = grid.dimensions();
+    if (x0 >= static_cast<int64_t>(width) || y0 >= static_cast<int64_t>(height)) {
+        return empty(level);
+    }
+    if (level == 0) {
+        return grid.at(static_cast<size_t>(x0), static_cast<size_t>(y0)).value() != 0 ? 1 : 0;
+    }
+    const int64_t half = int64_t{1} << (level - 1);
+    const NodeId nw = build(grid, level - 1, x0, y0);
+    const NodeId ne = build(grid, level - 1, x0 + half, y0);
+    const NodeId sw = build(grid, level - 1, x0, y0 + half);
+    const NodeId se = build(grid, level - 1, x0 + half, y0 + half);
+    return make(nw, ne, sw, se);
+}
+
+void HashLife::copy_to(NodeId node, AutomatonGrid& grid, int64_t x, int64_t y,
+                       int64_t x0, int64_t y0, size_t width, size_t height) const {
+    const Node& n = nodes_[node];
+    const int64_t size = int64_t{1} << n.level;
+    if (n.population == 0 || x + size <= x0 || y + size <= y0 ||
+        x >= x0 + static_cast<int64_t>(width) || y >= y0 + static_cast<int64_t>(height)) {
+        return;
+    }
+    if (n.level == 0) {
+        grid.set(static_cast<size_t>(x - x0), static_cast<size_t>(y - y0), CellState(1));
+        return;
+    }
+    const int64_t half = size / 2;
+    copy_to(n.nw, grid, x, y, x0, y0, width, height);
+    copy_to(n.ne, grid, x + half, y, x0, y0, width, height);
+    copy_to(n.sw, grid, x, y + half, x0, y0, width, height);
+    copy_to(n.se, grid, x + half, y + half, x0, y0, width, height);
+}
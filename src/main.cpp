@@ -1,9 +1,14 @@
 #include "automation.hpp"
+#include "ensemble.hpp"
+#include "frame_renderer.hpp"
 #include "rang.hpp"
 #include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <thread>
 #include <iostream>
 #include <iomanip>
+#include <string>
 
 using namespace std::chrono_literals;  
 
@@ -13,7 +18,13 @@ class AutomatonVisualizer {
     static constexpr size_t GRID_SIZE = 60;
     static constexpr size_t GRID_HEIGHT = 30;
 
+    double fps_;
+    double gps_;
+
 public:
+    // gps == 0 evolves as fast as possible; the display still runs at `fps`
+    explicit AutomatonVisualizer(double fps = 30, double gps = 10) : fps_(fps), gps_(gps) {}
+
     void run() {
         std::cout << rang::style::bold << rang::fg::cyan 
                   << "Advanced Cellular Automaton Simulator" 
@@ -21,20 +32,42 @@ public:
 
         auto rule = select_rule();
         AutomatonGrid grid(GRID_SIZE, GRID_HEIGHT, rule);
+        grid.set_metrics(true, 0);
 
         // ? Fix: Use `rules::` explicitly
         if (rule == rules::game_of_life_rule) {
             initialize_glider(grid);
         }
 
-        std::cout << "[2J[H[s";
+        std::cout << "\x1b[2J\x1b[H";
+        std::cout.flush();
+
+        FrameRenderer renderer(GRID_SIZE, GRID_HEIGHT);
+        FramePacer pacer(fps_, gps_);
+        char status[128];
 
         while (true) {
-            std::cout << "[u";
-            display_grid(grid);
-            grid.evolve();
-            std::this_thread::sleep_for(100ms);
-            std::cout.flush();
+            auto now = FramePacer::Clock::now();
+            if (pacer.generation_due(now)) {
+                grid.evolve();
+                pacer.generation_done(now);
+            }
+            now = FramePacer::Clock::now();
+            if (pacer.frame_due(now)) {
+                // Metrics describe the last evolve(), so there is no population until the first one
+                if (grid.generation() == 0) {
+                    std::snprintf(status, sizeof(status), "generation 0  %.1f fps  %.1f gps",
+                                  pacer.fps(), pacer.gps());
+                } else {
+                    std::snprintf(status, sizeof(status), "generation %llu  population %llu  %.1f fps  %.1f gps",
+                                  static_cast<unsigned long long>(grid.generation()),
+                                  static_cast<unsigned long long>(grid.last_metrics().population()),
+                                  pacer.fps(), pacer.gps());
+                }
+                renderer.render(grid, status);
+                pacer.frame_done(now);
+            }
+            pacer.wait(FramePacer::Clock::now());
         }
     }
 
@@ -54,6 +87,19 @@ private:
         }
     }
 
+public:
+    static AutomatonGrid::RuleFunction rule_by_number(int choice) {
+        // ? Fix: Explicitly reference `rules::`
+        switch (choice) {
+            case 1: return &rules::cyclic_rule;
+            case 2: return &rules::majority_rule;
+            case 3: return &rules::xor_rule;
+            case 4: return &rules::game_of_life_rule;
+            default: return &rules::cyclic_rule;
+        }
+    }
+
+private:
     static AutomatonGrid::RuleFunction select_rule() {
         std::cout << "Available Rules:\n"
                   << "1. BZ-Inspired (Spiral patterns)\n"
@@ -64,32 +110,78 @@ private:
 
         int choice;
         std::cin >> choice;
-
-        // ? Fix: Explicitly reference `rules::`
-        switch (choice) {
-            case 1: return &rules::cyclic_rule;
-            case 2: return &rules::majority_rule;
-            case 3: return &rules::xor_rule;
-            case 4: return &rules::game_of_life_rule;
-            default: return &rules::cyclic_rule;
-        }
+        return rule_by_number(choice);
     }
+};
 
-    static void display_grid(const AutomatonGrid& grid) {
-        auto [width, height] = grid.dimensions();
+// Headless batch mode: evolve many random grids together and write one
+// summary line per grid
+struct EnsembleOptions {
+    size_t count = 0;
+    size_t size = 64;
+    int rule = 1;
+    size_t generations = 1000;
+    std::uint64_t seed = 1;
+    size_t threads = std::thread::hardware_concurrency();
+    std::string output;
+};
 
-        for (size_t y = 0; y < height; ++y) {
-            for (size_t x = 0; x < width; ++x) {
-                char symbol = grid.at(x, y).value() > 0 ? '#' : '.';
-                std::cout << symbol << ' ';
-            }
+static void run_ensemble(const EnsembleOptions& options) {
+    auto rule = AutomatonVisualizer::rule_by_number(options.rule);
+    Ensemble ensemble(options.count, options.size, options.size, rule);
+    ensemble.randomize(options.seed, rule == rules::game_of_life_rule ? 2 : 16);
+    ensemble.set_threads(options.threads);
+
+    const auto start = std::chrono::steady_clock::now();
+    ensemble.evolve(options.generations);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (options.output.empty()) {
+        ensemble.write_summary(std::cout);
+    } else {
+        std::ofstream out(options.output);
+        ensemble.write_summary(out);
+        if (!out) {
+            throw std::runtime_error("failed to write " + options.output);
         }
     }
-};
 
-int main() {
+    const double cells = static_cast<double>(options.count * options.size * options.size * options.generations);
+    std::cerr << options.count << " grids x " << options.generations << " generations in "
+              << elapsed.count() << " s (" << cells / elapsed.count() / 1e6 << " Mcells/s)" << std::endl;
+}
+
+int main(int argc, char** argv) {
     try {
-        AutomatonVisualizer visualizer;
+        double fps = 30, gps = 10;
+        EnsembleOptions ensemble;
+        for (int i = 1; i < argc; i += 2) {
+            const std::string option = argv[i];
+            if (i + 1 >= argc) throw std::invalid_argument("missing value for " + option);
+            const std::string value = argv[i + 1];
+            if (option == "--fps") fps = std::stod(value);
+            else if (option == "--gps") gps = std::stod(value);
+            else if (option == "--ensemble") ensemble.count = std::stoull(value);
+            else if (option == "--size") ensemble.size = std::stoull(value);
+            else if (option == "--rule") ensemble.rule = std::stoi(value);
+            else if (option == "--generations") ensemble.generations = std::stoull(value);
+            else if (option == "--seed") ensemble.seed = std::stoull(value);
+            else if (option == "--threads") ensemble.threads = std::stoull(value);
+            else if (option == "--output") ensemble.output = value;
+            else throw std::invalid_argument("unknown option " + option);
+        }
+        // An unpaced display would redraw in a busy loop
+        if (!(fps > 0)) throw std::invalid_argument("--fps must be greater than 0");
+        if (gps < 0) throw std::invalid_argument("--gps must not be negative");
+        // rule_by_number falls back to the cyclic rule, which would mislabel a whole sweep
+        if (ensemble.rule < 1 || ensemble.rule > 4) throw std::invalid_argument("--rule must be 1-4");
+
+        if (ensemble.count > 0) {
+            run_ensemble(ensemble);
+            return 0;
+        }
+
+        AutomatonVisualizer visualizer(fps, gps);
         visualizer.run();
     } catch (const std::exception& e) {
         std::cerr << rang::fg::red
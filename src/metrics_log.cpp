@@ -0,0 +1,37 @@
+#include "metrics_log.hpp"
+#include <ostream>
+
+MetricsLog::MetricsLog(std::ostream& out, MetricsFormat format, size_t flush_every)
+    : out_(&out), format_(format), flush_every_(flush_every) {
+    if (format_ == MetricsFormat::Csv) {
+        *out_ << "generation,seconds,cells_evaluated,cells_changed,population";
+        for (int state = 0; state < 16; ++state) {
+            *out_ << ",state_" << state;
+        }
+        *out_ << '\n';
+    }
+}
+
+void MetricsLog::operator()(const GenerationMetrics& metrics) {
+    if (format_ == MetricsFormat::Csv) {
+        *out_ << metrics.generation << ',' << metrics.seconds << ',' << metrics.cells_evaluated << ','
+              << metrics.cells_changed << ',' << metrics.population();
+        for (auto count : metrics.histogram) {
+            *out_ << ',' << count;
+        }
+    } else {
+        *out_ << "{\"generation\":" << metrics.generation << ",\"seconds\":" << metrics.seconds
+              << ",\"cells_evaluated\":" << metrics.cells_evaluated
+              << ",\"cells_changed\":" << metrics.cells_changed
+              << ",\"population\":" << metrics.population() << ",\"histogram\":[";
+        for (size_t s = 0; s < metrics.histogram.size(); ++s) {
+            *out_ << (s ? "," : "") << metrics.histogram[s];
+        }
+        *out_ << "]}";
+    }
+    *out_ << '\n';
+    if (++pending_ >= flush_every_) {
+        out_->flush();
+        pending_ = 0;
+    }
+}
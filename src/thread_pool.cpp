@@ -0,0 +1,123 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads) {
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 1; i < threads; ++i) {
+        workers_.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    workers_.clear();
+}
+
+size_t ThreadPool::size() const { return queues_.size(); }
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    if (size() == 1 || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+
+    Batch batch{&body, count, {}, {}, {}};
+    {
+        std::lock_guard lock(wake_mutex_);
+        pending_ += count;
+    }
+
+    // Hand each thread a contiguous block so neighbouring work stays together
+    const size_t threads = size();
+    for (size_t q = 0; q < threads; ++q) {
+        const size_t begin = count * q / threads;
+        const size_t end = count * (q + 1) / threads;
+        std::lock_guard lock(queues_[q]->mutex);
+        for (size_t i = begin; i < end; ++i) {
+            queues_[q]->tasks.push_back({&batch, i});
+        }
+    }
+    wake_.notify_all();
+
+    Task task;
+    while (try_pop(0, task)) {
+        run(task);
+    }
+
+    std::unique_lock lock(batch.mutex);
+    batch.done.wait(lock, [&batch] { return batch.remaining == 0; });
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+bool ThreadPool::try_pop(size_t self, Task& task) {
+    {
+        auto& own = *queues_[self];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            --pending_;
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < queues_.size(); ++offset) {
+        auto& victim = *queues_[(self + offset) % queues_.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            --pending_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(const Task& task) {
+    Batch& batch = *task.batch;
+    std::exception_ptr error;
+    try {
+        (*batch.body)(task.index);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    // Hold the lock through the notify: the waiter owns `batch` and may destroy
+    // it as soon as it observes remaining == 0
+    std::lock_guard lock(batch.mutex);
+    if (error && !batch.error) {
+        batch.error = error;
+    }
+    if (--batch.remaining == 0) {
+        batch.done.notify_all();
+    }
+}
+
+void ThreadPool::worker_loop(size_t self) {
+    Task task;
+    while (true) {
+        if (try_pop(self, task)) {
+            run(task);
+            continue;
+        }
+        std::unique_lock lock(wake_mutex_);
+        wake_.wait(lock, [this] { return stopping_ || pending_ > 0; });
+        if (stopping_ && pending_ == 0) {
+            return;
+        }
+    }
+}
@@ -1,7 +1,79 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 #include "automation.hpp"
+#include "ensemble.hpp"
+#include "frame_renderer.hpp"
+#include "grid_io.hpp"
+#include "hashlife.hpp"
+#include "metrics_log.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 #include <random>
+#include <sstream>
+#include <stdexcept>
+
+// Count every heap allocation so tests can assert that hot paths stay allocation-free
+namespace {
+    std::atomic<size_t> allocation_count{0};
+}
+
+[[gnu::noinline]] void* operator new(std::size_t size) {
+    ++allocation_count;
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept { std::free(ptr); }
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace {
+    // Straightforward per-cell evaluation used as the reference for optimized paths
+    std::vector<unsigned> reference_step(const AutomatonGrid& grid, AutomatonGrid::RuleFunction rule) {
+        auto [width, height] = grid.dimensions();
+        std::vector<unsigned> next(width * height);
+        for (size_t y = 0; y < height; ++y) {
+            for (size_t x = 0; x < width; ++x) {
+                auto neighbors = grid.get_neighborhood(x, y);
+                unsigned value = rule(neighbors).value();
+                next[y * width + x] = grid.storage() == CellStorage::Bit ? value != 0 : value;
+            }
+        }
+        return next;
+    }
+
+    std::vector<unsigned> snapshot(const AutomatonGrid& grid) {
+        auto [width, height] = grid.dimensions();
+        std::vector<unsigned> cells(width * height);
+        for (size_t y = 0; y < height; ++y) {
+            for (size_t x = 0; x < width; ++x) {
+                cells[y * width + x] = grid.at(x, y).value();
+            }
+        }
+        return cells;
+    }
+
+    void fill_random(AutomatonGrid& grid, unsigned seed, unsigned max_state = 15) {
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<unsigned> dis(0, max_state);
+        auto [width, height] = grid.dimensions();
+        for (size_t y = 0; y < height; ++y) {
+            for (size_t x = 0; x < width; ++x) {
+                grid.set(x, y, CellState(dis(gen)));
+            }
+        }
+    }
+
+    const AutomatonGrid::RuleFunction all_rules[] = {
+        rules::game_of_life_rule, rules::cyclic_rule, rules::majority_rule, rules::xor_rule
+    };
+}
 
 TEST_CASE("CellState basic operations", "[cell]") {
     CellState cell;
@@ -62,6 +134,9 @@ TEST_CASE("AutomatonGrid operations", "[grid]") {
         auto neighbors = grid.get_neighborhood(1, 1);
         REQUIRE(neighbors.size() == 9);
         REQUIRE(neighbors[4].value() == 1);  // Center cell
+
+        auto wrapped = grid.neighborhood(0, 0);
+        REQUIRE(wrapped[8].value() == 1);    // (1, 1) is south-east of the corner
     }
     
     SECTION("Evolution with cyclic rule") {
@@ -77,6 +152,755 @@ TEST_CASE("AutomatonGrid operations", "[grid]") {
     }
 }
 
+TEST_CASE("Evolution matches per-cell reference", "[grid]") {
+    for (auto storage : {CellStorage::Word32, CellStorage::Nibble, CellStorage::Bit}) {
+        for (auto rule : all_rules) {
+            for (auto [width, height] : {std::pair<size_t, size_t>{17, 9}, {1, 5}, {2, 2}, {64, 3}, {70, 4}}) {
+                AutomatonGrid grid(width, height, rule, storage);
+                fill_random(grid, 42, rule == rules::game_of_life_rule ? 1 : 15);
+
+                for (int generation = 0; generation < 4; ++generation) {
+                    auto expected = reference_step(grid, rule);
+                    grid.evolve();
+                    REQUIRE(snapshot(grid) == expected);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Packed storage backends", "[grid]") {
+    SECTION("Nibble storage keeps every state") {
+        AutomatonGrid grid(33, 3, rules::cyclic_rule, CellStorage::Nibble);
+        for (unsigned value = 0; value < 16; ++value) {
+            grid.set(value * 2, 1, CellState(value));
+        }
+        for (unsigned value = 0; value < 16; ++value) {
+            REQUIRE(grid.at(value * 2, 1).value() == value);
+            REQUIRE(grid.at(value * 2 + 1, 1).value() == 0);
+        }
+    }
+
+    SECTION("Bit storage clamps to alive/dead") {
+        AutomatonGrid grid(65, 2, rules::game_of_life_rule, CellStorage::Bit);
+        grid.set(64, 1, CellState(9));
+        grid.set(63, 1, CellState(1));
+        grid.set(63, 1, CellState(0));
+        REQUIRE(grid.at(64, 1).value() == 1);
+        REQUIRE(grid.at(63, 1).value() == 0);
+        REQUIRE(grid.storage() == CellStorage::Bit);
+    }
+}
+
+TEST_CASE("Evolution does not allocate", "[grid]") {
+    for (auto rule : all_rules) {
+        AutomatonGrid grid(48, 32, rule);
+        fill_random(grid, 7);
+
+        size_t before = allocation_count;
+        for (int generation = 0; generation < 10; ++generation) {
+            grid.evolve();
+        }
+        REQUIRE(allocation_count == before);
+    }
+}
+
+TEST_CASE("Compile-time rules", "[grid][rules]") {
+    SECTION("Functor and lambda rules match the function pointers") {
+        AutomatonGrid pointer(70, 40, rules::majority_rule, CellStorage::Nibble);
+        AutomatonGrid functor(70, 40, rules::Majority{}, CellStorage::Nibble);
+        auto lambda_rule = [](std::span<const CellState> n) { return rules::majority_rule(n); };
+        AutomatonGrid lambda(70, 40, lambda_rule, CellStorage::Nibble);
+        fill_random(pointer, 3);
+        fill_random(functor, 3);
+        fill_random(lambda, 3);
+
+        for (int generation = 0; generation < 5; ++generation) {
+            pointer.evolve();
+            functor.evolve();
+            lambda.evolve();
+        }
+        REQUIRE(snapshot(functor) == snapshot(pointer));
+        REQUIRE(snapshot(lambda) == snapshot(pointer));
+    }
+
+    SECTION("GameOfLife functor keeps the bit-sliced engine") {
+        AutomatonGrid grid(64, 64, rules::GameOfLife{}, CellStorage::Bit);
+        REQUIRE(grid.engine() == EvolveEngine::BitSlicedLife);
+    }
+
+    SECTION("Life-like rulestrings") {
+        // game_of_life_rule counts the centre cell, which makes it B3/S12
+        AutomatonGrid builtin(90, 50, rules::game_of_life_rule, CellStorage::Bit);
+        AutomatonGrid table(90, 50, rules::LifeLike("B3/S12"), CellStorage::Bit);
+        fill_random(builtin, 17, 1);
+        fill_random(table, 17, 1);
+        for (int generation = 0; generation < 8; ++generation) {
+            builtin.evolve();
+            table.evolve();
+            REQUIRE(snapshot(table) == snapshot(builtin));
+        }
+
+        // Conway's blinker oscillates with period 2, in either notation
+        for (auto rulestring : {"B3/S23", "23/3", "s23/b3"}) {
+            AutomatonGrid conway(5, 5, rules::LifeLike(rulestring));
+            conway.set(1, 2, CellState(1));
+            conway.set(2, 2, CellState(1));
+            conway.set(3, 2, CellState(1));
+            conway.evolve();
+            REQUIRE(conway.at(2, 1).value() == 1);
+            REQUIRE(conway.at(1, 2).value() == 0);
+            conway.evolve();
+            REQUIRE(conway.at(1, 2).value() == 1);
+        }
+
+        REQUIRE_THROWS_AS(rules::LifeLike("B9/S23"), std::invalid_argument);
+        REQUIRE_THROWS_AS(rules::LifeLike("B3S23"), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Bit-sliced Life engine", "[grid][life]") {
+    SECTION("Engine selection") {
+        AutomatonGrid life(8, 8, rules::game_of_life_rule, CellStorage::Bit);
+        REQUIRE(life.engine() == EvolveEngine::BitSlicedLife);
+        life.set_engine(EvolveEngine::Stencil);
+        REQUIRE(life.engine() == EvolveEngine::Stencil);
+
+        AutomatonGrid wide(8, 8, rules::game_of_life_rule, CellStorage::Nibble);
+        REQUIRE(wide.engine() == EvolveEngine::Stencil);
+        REQUIRE_THROWS_AS(wide.set_engine(EvolveEngine::BitSlicedLife), std::invalid_argument);
+    }
+
+    SECTION("Identical to the stencil on toroidal grids") {
+        for (auto [width, height] : {std::pair<size_t, size_t>{1, 1}, {3, 1}, {63, 7}, {64, 64}, {65, 9}, {130, 17}, {200, 3}}) {
+            AutomatonGrid fast(width, height, rules::game_of_life_rule, CellStorage::Bit);
+            AutomatonGrid slow(width, height, rules::game_of_life_rule, CellStorage::Bit);
+            slow.set_engine(EvolveEngine::Stencil);
+            fill_random(fast, 1234, 1);
+            fill_random(slow, 1234, 1);
+
+            for (int generation = 0; generation < 20; ++generation) {
+                fast.evolve();
+                slow.evolve();
+                REQUIRE(snapshot(fast) == snapshot(slow));
+            }
+        }
+    }
+}
+
+TEST_CASE("Parallel evolution", "[grid][parallel]") {
+    SECTION("Matches the serial path for every rule and storage") {
+        for (auto storage : {CellStorage::Word32, CellStorage::Nibble, CellStorage::Bit}) {
+            for (auto rule : all_rules) {
+                AutomatonGrid serial(97, 200, rule, storage);
+                AutomatonGrid parallel(97, 200, rule, storage);
+                parallel.set_threads(4);
+                REQUIRE(parallel.threads() == 4);
+                fill_random(serial, 99, rule == rules::game_of_life_rule ? 1 : 15);
+                fill_random(parallel, 99, rule == rules::game_of_life_rule ? 1 : 15);
+
+                for (int generation = 0; generation < 5; ++generation) {
+                    serial.evolve();
+                    parallel.evolve();
+                }
+                REQUIRE(snapshot(parallel) == snapshot(serial));
+            }
+        }
+    }
+
+    SECTION("Shared pool") {
+        auto pool = std::make_shared<ThreadPool>(3);
+        AutomatonGrid a(40, 300, rules::xor_rule);
+        AutomatonGrid b(40, 300, rules::xor_rule);
+        a.set_thread_pool(pool);
+        fill_random(a, 5);
+        fill_random(b, 5);
+        a.evolve();
+        b.evolve();
+        REQUIRE(snapshot(a) == snapshot(b));
+        a.set_thread_pool(nullptr);
+        REQUIRE(a.threads() == 1);
+    }
+
+    SECTION("Thread pool runs every index once and propagates exceptions") {
+        ThreadPool pool(4);
+        std::vector<std::atomic<int>> hits(1000);
+        pool.parallel_for(hits.size(), [&](size_t i) { ++hits[i]; });
+        REQUIRE(std::all_of(hits.begin(), hits.end(), [](const auto& hit) { return hit == 1; }));
+
+        REQUIRE_THROWS_AS(pool.parallel_for(10, [](size_t i) {
+            if (i == 7) throw std::runtime_error("boom");
+        }), std::runtime_error);
+    }
+}
+
+TEST_CASE("Active-region tracking", "[grid][activity]") {
+    SECTION("Matches full evaluation for every rule and storage") {
+        for (auto storage : {CellStorage::Word32, CellStorage::Nibble, CellStorage::Bit}) {
+            for (auto rule : all_rules) {
+                AutomatonGrid full(200, 150, rule, storage);
+                AutomatonGrid tracked(200, 150, rule, storage);
+                tracked.set_active_tracking(true);
+                if (rule == all_rules[0]) {
+                    tracked.set_threads(3);
+                }
+
+                // Activity confined to a patch that straddles a tile corner
+                std::mt19937 gen(11);
+                for (size_t y = 60; y < 70; ++y) {
+                    for (size_t x = 58; x < 70; ++x) {
+                        CellState state(gen() % (rule == rules::game_of_life_rule ? 2 : 16));
+                        full.set(x, y, state);
+                        tracked.set(x, y, state);
+                    }
+                }
+
+                for (int generation = 0; generation < 12; ++generation) {
+                    if (generation == 6) {
+                        full.set(199, 149, CellState(3));
+                        tracked.set(199, 149, CellState(3));
+                    }
+                    full.evolve();
+                    tracked.evolve();
+                    REQUIRE(snapshot(tracked) == snapshot(full));
+                }
+            }
+        }
+    }
+
+    SECTION("Quiet grids skip tiles") {
+        AutomatonGrid grid(640, 640, rules::game_of_life_rule, CellStorage::Bit);
+        grid.set_active_tracking(true);
+        grid.evolve();
+        REQUIRE(grid.activity().tiles == 100);
+        REQUIRE(grid.activity().tiles_evaluated == 100);
+
+        grid.evolve();
+        REQUIRE(grid.activity().tiles_skipped == 100);
+
+        grid.set(320, 320, CellState(1));
+        grid.evolve();
+        REQUIRE(grid.activity().tiles_evaluated == 9);
+        REQUIRE(grid.at(320, 320).value() == 0);
+    }
+}
+
+TEST_CASE("Reproducible random fill", "[grid][random]") {
+    SECTION("Independent of thread count and storage") {
+        AutomatonGrid serial(300, 200, rules::cyclic_rule);
+        AutomatonGrid parallel(300, 200, rules::cyclic_rule, CellStorage::Nibble);
+        AutomatonGrid bits(300, 200, rules::game_of_life_rule, CellStorage::Bit);
+        parallel.set_threads(4);
+        serial.randomize(11, 0.3, 16);
+        parallel.randomize(11, 0.3, 16);
+        bits.randomize(11, 0.3, 16);
+        REQUIRE(snapshot(serial) == snapshot(parallel));
+        for (size_t y = 0; y < 200; ++y) {
+            for (size_t x = 0; x < 300; ++x) {
+                REQUIRE(bits.at(x, y).value() == (serial.at(x, y).value() != 0));
+            }
+        }
+
+        AutomatonGrid other(300, 200, rules::cyclic_rule);
+        other.randomize(12, 0.3, 16);
+        REQUIRE(snapshot(other) != snapshot(serial));
+    }
+
+    SECTION("Density and state weights") {
+        AutomatonGrid grid(256, 256, rules::cyclic_rule);
+        grid.randomize(5, 0.25, 4);
+        std::array<size_t, 16> counts{};
+        for (size_t y = 0; y < 256; ++y) {
+            for (size_t x = 0; x < 256; ++x) {
+                ++counts[grid.at(x, y).value()];
+            }
+        }
+        REQUIRE(counts[0] == Approx(0.75 * 65536).epsilon(0.02));
+        for (unsigned s = 1; s < 4; ++s) {
+            REQUIRE(counts[s] == Approx(65536 / 12.0).epsilon(0.05));
+        }
+        REQUIRE(counts[4] == 0);
+
+        const double weights[] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+        grid.randomize(5, weights);
+        REQUIRE(grid.at(17, 99).value() == 7);
+
+        REQUIRE_THROWS_AS(grid.randomize(5, 1.5), std::invalid_argument);
+        REQUIRE_THROWS_AS(grid.randomize(5, 0.5, 17), std::invalid_argument);
+        REQUIRE_THROWS_AS(grid.randomize(5, std::span<const double>{}), std::invalid_argument);
+    }
+
+    SECTION("Marks every tile for active tracking") {
+        AutomatonGrid tracked(200, 200, rules::game_of_life_rule, CellStorage::Bit);
+        AutomatonGrid full(200, 200, rules::game_of_life_rule, CellStorage::Bit);
+        tracked.set_active_tracking(true);
+        for (int i = 0; i < 3; ++i) {
+            tracked.evolve();
+        }
+        tracked.randomize(3);
+        full.randomize(3);
+        for (int i = 0; i < 4; ++i) {
+            tracked.evolve();
+            full.evolve();
+            REQUIRE(snapshot(tracked) == snapshot(full));
+        }
+    }
+}
+
+TEST_CASE("Generation metrics", "[grid][metrics]") {
+    auto check = [](const AutomatonGrid& grid, const std::vector<unsigned>& before) {
+        const auto after = snapshot(grid);
+        const auto& metrics = grid.last_metrics();
+        std::array<std::uint64_t, 16> histogram{};
+        std::uint64_t changed = 0;
+        for (size_t i = 0; i < after.size(); ++i) {
+            ++histogram[after[i]];
+            changed += after[i] != before[i];
+        }
+        REQUIRE(metrics.generation == grid.generation());
+        REQUIRE(metrics.histogram == histogram);
+        REQUIRE(metrics.cells_changed == changed);
+        REQUIRE(metrics.population() == after.size() - histogram[0]);
+    };
+
+    SECTION("Counts match a scan for every rule, storage and engine") {
+        for (auto storage : {CellStorage::Word32, CellStorage::Nibble, CellStorage::Bit}) {
+            for (auto rule : all_rules) {
+                for (bool tracking : {false, true}) {
+                    AutomatonGrid grid(150, 100, rule, storage);
+                    grid.set_active_tracking(tracking);
+                    grid.set_metrics(true);
+                    grid.set_threads(2);
+                    grid.randomize(8, 0.4, rule == rules::game_of_life_rule ? 2 : 16);
+                    for (int generation = 0; generation < 5; ++generation) {
+                        auto before = snapshot(grid);
+                        grid.evolve();
+                        check(grid, before);
+                        if (!tracking) {
+                            REQUIRE(grid.last_metrics().cells_evaluated == 150 * 100);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("Skipped tiles keep their histogram") {
+        AutomatonGrid grid(640, 640, rules::game_of_life_rule, CellStorage::Bit);
+        grid.set_active_tracking(true);
+        grid.set_metrics(true, 3);
+        // A blinker far from everything plus a still block
+        for (auto [x, y] : {std::pair<size_t, size_t>{100, 100}, {101, 100}, {102, 100}, {400, 400}, {401, 400}, {400, 401}, {401, 401}}) {
+            grid.set(x, y, CellState(1));
+        }
+        for (int generation = 0; generation < 5; ++generation) {
+            auto before = snapshot(grid);
+            grid.evolve();
+            check(grid, before);
+        }
+        REQUIRE(grid.last_metrics().cells_evaluated < 640 * 640);
+        REQUIRE(grid.last_metrics().seconds >= 0);
+
+        auto history = grid.metrics_history();
+        REQUIRE(history.size() == 3);
+        REQUIRE(history.front().generation == 3);
+        REQUIRE(history.back().generation == 5);
+    }
+
+    SECTION("Streaming sink") {
+        std::ostringstream csv, json;
+        AutomatonGrid grid(32, 32, rules::cyclic_rule);
+        grid.set_metrics(true);
+        grid.set_metrics_sink(MetricsLog(csv));
+        grid.evolve();
+        grid.evolve();
+        grid.set_metrics_sink(MetricsLog(json, MetricsFormat::JsonLines));
+        grid.evolve();
+
+        const std::string rows = csv.str();
+        REQUIRE(rows.rfind("generation,seconds,cells_evaluated,cells_changed,population,state_0,", 0) == 0);
+        REQUIRE(std::count(rows.begin(), rows.end(), '\n') == 3);
+        REQUIRE(json.str().rfind("{\"generation\":3,", 0) == 0);
+        REQUIRE(json.str().find("\"histogram\":[1024,0,") != std::string::npos);
+    }
+}
+
+TEST_CASE("Cycle detection", "[grid][cycle]") {
+    SECTION("Incremental hash matches a full rehash") {
+        for (auto storage : {CellStorage::Word32, CellStorage::Nibble, CellStorage::Bit}) {
+            for (auto rule : all_rules) {
+                for (bool tracking : {false, true}) {
+                    AutomatonGrid grid(150, 100, rule, storage);
+                    grid.set_active_tracking(tracking);
+                    grid.set_threads(2);
+                    grid.set_cycle_detection(true);
+                    grid.randomize(4, 0.4, rule == rules::game_of_life_rule ? 2 : 16);
+                    for (int generation = 0; generation < 5; ++generation) {
+                        if (generation == 3) {
+                            grid.set(149, 99, CellState(9));
+                        }
+                        grid.evolve();
+                        AutomatonGrid copy(150, 100, rule, storage);
+                        copy.replace_cells(grid.cells(), grid.generation());
+                        REQUIRE(grid.hash() == copy.hash());
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("Nearby states hash apart") {
+        AutomatonGrid grid(64, 64, rules::game_of_life_rule, CellStorage::Bit);
+        grid.set_cycle_detection(true);
+        std::vector<std::uint64_t> hashes{grid.hash()};
+        for (size_t y = 0; y < 64; ++y) {
+            for (size_t x = 0; x < 64; ++x) {
+                grid.set(x, y, CellState(1));
+                hashes.push_back(grid.hash());
+                grid.set((x + 1) % 64, y, CellState(1));
+                hashes.push_back(grid.hash());
+                grid.set(x, y, CellState(0));
+                grid.set((x + 1) % 64, y, CellState(0));
+            }
+        }
+        std::sort(hashes.begin(), hashes.end());
+        REQUIRE(std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end());
+    }
+
+    SECTION("Oscillators and still lifes") {
+        AutomatonGrid grid(32, 32, rules::game_of_life_rule, CellStorage::Bit);
+        grid.set_cycle_detection(true);
+        // A domino is a still life under game_of_life_rule, which counts the centre cell
+        grid.set(4, 4, CellState(1));
+        grid.set(5, 4, CellState(1));
+        REQUIRE(!grid.cycle_candidate());
+        grid.evolve();
+        REQUIRE(grid.cycle_candidate());
+        REQUIRE(grid.cycle_candidate()->period == 1);
+
+        auto result = grid.run(1000, CycleAction::Stop);
+        REQUIRE(result.cycle);
+        REQUIRE(result.cycle->period == 1);
+        REQUIRE(grid.generation() < 10);
+    }
+
+    SECTION("Skipping ahead matches a full run") {
+        // A B3/S23 glider on a 16x16 torus repeats every 64 generations
+        AutomatonGrid skipped(16, 16, rules::LifeLike("B3/S23"), CellStorage::Bit);
+        AutomatonGrid full(16, 16, rules::LifeLike("B3/S23"), CellStorage::Bit);
+        for (auto [x, y] : {std::pair<size_t, size_t>{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}}) {
+            skipped.set(x, y, CellState(1));
+            full.set(x, y, CellState(1));
+        }
+        for (std::uint64_t i = 0; i < 10007; ++i) {
+            full.evolve();
+        }
+
+        auto result = skipped.run(10007);
+        REQUIRE(result.cycle);
+        REQUIRE(result.cycle->period == 64);
+        REQUIRE(result.evolved < 10007);
+        REQUIRE(skipped.generation() == 10007);
+        REQUIRE(snapshot(skipped) == snapshot(full));
+    }
+
+    SECTION("Runs without a cycle are unchanged") {
+        AutomatonGrid ran(64, 64, rules::cyclic_rule, CellStorage::Nibble);
+        AutomatonGrid evolved(64, 64, rules::cyclic_rule, CellStorage::Nibble);
+        ran.randomize(19);
+        evolved.randomize(19);
+        auto result = ran.run(40);
+        for (int i = 0; i < 40; ++i) {
+            evolved.evolve();
+        }
+        REQUIRE(ran.generation() == 40);
+        REQUIRE(snapshot(ran) == snapshot(evolved));
+        if (!result.cycle) {
+            REQUIRE(result.evolved == 40);
+        }
+    }
+}
+
+TEST_CASE("Binary snapshots", "[io]") {
+    const auto path = (std::filesystem::temp_directory_path() / "automaton_snapshot_test.bin").string();
+
+    for (auto storage : {CellStorage::Word32, CellStorage::Nibble, CellStorage::Bit}) {
+        AutomatonGrid grid(77, 31, rules::cyclic_rule, storage);
+        fill_random(grid, 21);
+        grid.evolve();
+        grid.evolve();
+        grid_io::save_snapshot(grid, path);
+
+        auto header = grid_io::read_snapshot_header(path);
+        REQUIRE(header.width == 77);
+        REQUIRE(header.height == 31);
+        REQUIRE(header.bits_per_cell == static_cast<unsigned>(storage));
+        REQUIRE(header.generation == 2);
+
+        AutomatonGrid loaded = grid_io::load_snapshot(path, rules::cyclic_rule);
+        REQUIRE(loaded.generation() == 2);
+        REQUIRE(loaded.storage() == storage);
+        REQUIRE(snapshot(loaded) == snapshot(grid));
+
+        // Edits stay private to the grid and never reach the file
+        loaded.set(0, 0, CellState(loaded.at(0, 0).value() ^ 1));
+        loaded.evolve();
+        grid.set(0, 0, CellState(grid.at(0, 0).value() ^ 1));
+        grid.evolve();
+        REQUIRE(snapshot(loaded) == snapshot(grid));
+        REQUIRE(grid_io::read_snapshot_header(path).generation == 2);
+    }
+
+    AutomatonGrid wrong_size(10, 10, rules::cyclic_rule, CellStorage::Bit);
+    REQUIRE_THROWS_AS(grid_io::load_snapshot(path, wrong_size), std::invalid_argument);
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "not a snapshot";
+    REQUIRE_THROWS_AS(grid_io::read_snapshot_header(path), std::runtime_error);
+
+    // Dimensions whose byte count wraps must not pass for a tiny file
+    grid_io::SnapshotHeader huge{};
+    std::memcpy(huge.magic, "CAGRID", 6);
+    huge.version = grid_io::snapshot_version;
+    huge.bits_per_cell = 4;
+    huge.width = std::uint64_t{1} << 60;
+    huge.height = 256;
+    huge.stride = (huge.width * huge.bits_per_cell + 63) / 64;
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+    REQUIRE_THROWS_AS(grid_io::read_snapshot_header(path), std::runtime_error);
+    REQUIRE_THROWS_AS(grid_io::load_snapshot(path, rules::cyclic_rule), std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("RLE patterns", "[io]") {
+    SECTION("Import places live cells") {
+        std::istringstream glider("#N Glider\n#C comment\nx = 3, y = 3, rule = B3/S23\nbo$2bo$3o!\n");
+        AutomatonGrid grid = grid_io::read_rle(glider, rules::game_of_life_rule, CellStorage::Bit);
+        REQUIRE(grid.dimensions() == std::pair<size_t, size_t>{3, 3});
+        REQUIRE(snapshot(grid) == std::vector<unsigned>{0, 1, 0, 0, 0, 1, 1, 1, 1});
+
+        std::istringstream again("x = 3, y = 3\nbo$2bo$3o!");
+        AutomatonGrid big(100, 100, rules::game_of_life_rule, CellStorage::Bit);
+        grid_io::load_rle(again, big, 50, 60);
+        REQUIRE(big.at(51, 60).value() == 1);
+        REQUIRE(big.at(52, 62).value() == 1);
+        REQUIRE(big.at(50, 60).value() == 0);
+    }
+
+    SECTION("Round trip") {
+        for (unsigned max_state : {1u, 15u}) {
+            AutomatonGrid grid(150, 40, rules::cyclic_rule, CellStorage::Nibble);
+            std::mt19937 gen(8);
+            for (int i = 0; i < 200; ++i) {
+                grid.set(gen() % 150, 5 + gen() % 30, CellState(1 + gen() % max_state));
+            }
+
+            std::stringstream text;
+            grid_io::write_rle(text, grid);
+            std::string line;
+            while (std::getline(text, line)) {
+                REQUIRE(line.size() <= 70);
+            }
+            text.clear();
+            text.seekg(0);
+
+            AutomatonGrid loaded = grid_io::read_rle(text, rules::cyclic_rule);
+            REQUIRE(snapshot(loaded) == snapshot(grid));
+        }
+    }
+
+    SECTION("Malformed input") {
+        AutomatonGrid grid(4, 4, rules::cyclic_rule);
+        std::istringstream too_big("x = 5, y = 1\n5o!");
+        REQUIRE_THROWS_AS(grid_io::load_rle(too_big, grid), std::out_of_range);
+        std::istringstream bad_tag("x = 2, y = 1\n2z!");
+        REQUIRE_THROWS_AS(grid_io::load_rle(bad_tag, grid), std::runtime_error);
+        std::istringstream no_header("bo$2bo!");
+        REQUIRE_THROWS_AS(grid_io::read_rle(no_header, rules::cyclic_rule), std::runtime_error);
+    }
+}
+
+TEST_CASE("Ensemble runner", "[ensemble]") {
+    SECTION("Every member evolves like its own AutomatonGrid") {
+        for (auto rule : all_rules) {
+            Ensemble batch(70, 20, 13, rule);
+            batch.randomize(100, rule == rules::game_of_life_rule ? 2 : 16);
+            Ensemble parallel(70, 20, 13, rule);
+            parallel.randomize(100, rule == rules::game_of_life_rule ? 2 : 16);
+            parallel.set_threads(3);
+
+            std::vector<AutomatonGrid> grids;
+            for (size_t g = 0; g < batch.size(); ++g) {
+                grids.emplace_back(20, 13, rule);
+                for (size_t y = 0; y < 13; ++y) {
+                    for (size_t x = 0; x < 20; ++x) {
+                        grids[g].set(x, y, batch.at(g, x, y));
+                    }
+                }
+            }
+
+            batch.evolve(6);
+            parallel.evolve(6);
+            for (auto& grid : grids) {
+                for (int i = 0; i < 6; ++i) {
+                    grid.evolve();
+                }
+            }
+
+            for (size_t g = 0; g < batch.size(); ++g) {
+                for (size_t y = 0; y < 13; ++y) {
+                    for (size_t x = 0; x < 20; ++x) {
+                        REQUIRE(batch.at(g, x, y).value() == grids[g].at(x, y).value());
+                        REQUIRE(parallel.at(g, x, y).value() == grids[g].at(x, y).value());
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("Summaries") {
+        Ensemble batch(2, 8, 8, rules::cyclic_rule);
+        batch.set(1, 3, 3, CellState(5));
+        auto summaries = batch.summarize();
+        REQUIRE(summaries[0].population == 0);
+        REQUIRE(summaries[1].population == 1);
+        REQUIRE(summaries[1].histogram[5] == 1);
+        REQUIRE(summaries[1].histogram[0] == 63);
+        REQUIRE(summaries[1].changed == 0);
+
+        batch.evolve();
+        REQUIRE(batch.generation() == 1);
+        REQUIRE(batch.summarize()[0].changed == 0);
+
+        std::ostringstream csv;
+        batch.write_summary(csv);
+        const std::string text = csv.str();
+        REQUIRE(text.rfind("grid,generation,population,changed,state_0,", 0) == 0);
+        REQUIRE(std::count(text.begin(), text.end(), '\n') == 3);
+    }
+
+    SECTION("Random fill rejects unusable state counts") {
+        Ensemble batch(2, 8, 8, rules::cyclic_rule);
+        REQUIRE_THROWS_AS(batch.randomize(1, 0), std::invalid_argument);
+        REQUIRE_THROWS_AS(batch.randomize(1, 17), std::invalid_argument);
+        REQUIRE_NOTHROW(batch.randomize(1, 16));
+    }
+}
+
+TEST_CASE("Frame renderer", "[render]") {
+    AutomatonGrid grid(4, 2, rules::game_of_life_rule);
+    FrameRenderer renderer(4, 2);
+
+    // The first frame draws every cell, moving the cursor once per row
+    REQUIRE(std::string(renderer.compose(grid, "gen 0")) ==
+            "\x1b[1;1H. . . . \x1b[2;1H. . . . \x1b[3;1Hgen 0\x1b[K");
+
+    // Nothing changed, nothing to write
+    REQUIRE(renderer.compose(grid, "gen 0").empty());
+
+    // Adjacent changes share one cursor move
+    grid.set(1, 1, CellState(1));
+    grid.set(2, 1, CellState(1));
+    REQUIRE(std::string(renderer.compose(grid, "gen 0")) == "\x1b[2;3H# # ");
+
+    size_t before = allocation_count;
+    grid.set(3, 0, CellState(1));
+    auto frame = renderer.compose(grid, "gen 1");
+    REQUIRE(allocation_count == before);
+    REQUIRE(std::string(frame) == "\x1b[1;7H# \x1b[3;1Hgen 1\x1b[K");
+
+    renderer.invalidate();
+    REQUIRE(renderer.compose(grid, "gen 1").size() > 16);
+}
+
+TEST_CASE("Frame pacer", "[render]") {
+    using namespace std::chrono_literals;
+    FramePacer pacer(10, 0);
+    auto start = FramePacer::Clock::now();
+    REQUIRE(pacer.frame_due(start));
+    REQUIRE(pacer.generation_due(start));
+
+    pacer.frame_done(start);
+    REQUIRE_FALSE(pacer.frame_due(start + 50ms));
+    REQUIRE(pacer.frame_due(start + 100ms));
+    // Unlimited generations are always due
+    pacer.generation_done(start);
+    REQUIRE(pacer.generation_due(start));
+
+    // A late frame does not queue up the ones it missed
+    pacer.frame_done(start + 500ms);
+    REQUIRE_FALSE(pacer.frame_due(start + 550ms));
+
+    for (int i = 0; i < 20; ++i) {
+        pacer.generation_done(start + 1s + i * 1ms);
+    }
+    REQUIRE(pacer.gps() > 0);
+    REQUIRE(pacer.fps() > 0);
+}
+
+TEST_CASE("HashLife engine", "[hashlife]") {
+    // A random blob in the middle of a grid large enough that it never reaches the edges
+    AutomatonGrid grid(96, 96, rules::game_of_life_rule, CellStorage::Bit);
+    std::mt19937 gen(2024);
+    for (size_t y = 42; y < 54; ++y) {
+        for (size_t x = 42; x < 54; ++x) {
+            grid.set(x, y, CellState(gen() % 2));
+        }
+    }
+
+    SECTION("Round trip through AutomatonGrid") {
+        HashLife life(grid);
+        REQUIRE(snapshot(life.to_grid(96, 96)) == snapshot(grid));
+        REQUIRE(life.at(-5, 3).value() == 0);
+
+        life.set(-5, 3, CellState(1));
+        REQUIRE(life.at(-5, 3).value() == 1);
+        REQUIRE(life.to_grid(2, 2, -6, 2).at(1, 1).value() == 1);
+    }
+
+    SECTION("Power-of-two and arbitrary steps match evolve") {
+        HashLife life(grid);
+        life.step(3);
+        REQUIRE(life.generation() == 8);
+        for (int i = 0; i < 8; ++i) {
+            grid.evolve();
+        }
+        REQUIRE(snapshot(life.to_grid(96, 96)) == snapshot(grid));
+
+        life.advance(13);
+        for (int i = 0; i < 13; ++i) {
+            grid.evolve();
+        }
+        REQUIRE(life.generation() == 21);
+        REQUIRE(snapshot(life.to_grid(96, 96)) == snapshot(grid));
+    }
+
+    SECTION("Garbage collection keeps results intact") {
+        HashLife unbounded(grid);
+        HashLife bounded(grid, 2000);
+        for (int i = 0; i < 5; ++i) {
+            unbounded.advance(7);
+            bounded.advance(7);
+        }
+        REQUIRE(bounded.population() == unbounded.population());
+        REQUIRE(snapshot(bounded.to_grid(96, 96)) == snapshot(unbounded.to_grid(96, 96)));
+
+        size_t before = unbounded.node_count();
+        unbounded.collect_garbage();
+        REQUIRE(unbounded.node_count() < before);
+        unbounded.advance(7);
+        bounded.advance(7);
+        REQUIRE(snapshot(bounded.to_grid(96, 96)) == snapshot(unbounded.to_grid(96, 96)));
+    }
+
+    SECTION("Exponential fast-forward") {
+        HashLife life(grid);
+        life.step(40);
+        REQUIRE(life.generation() == (uint64_t{1} << 40));
+        REQUIRE(life.population() > 0);
+        REQUIRE(life.node_count() < 100000);
+    }
+}
+
 TEST_CASE("Rule implementations", "[rules]") {
     SECTION("Cyclic rule") {
         std::vector<CellState> neighbors(9, CellState(0));